@@ -101,6 +101,47 @@ static void check_sector (struct block *block, block_sector_t sector)
     }
 }
 
+/* Verifies that the CNT sectors starting at SECTOR are all
+   within BLOCK.  Panics if not. */
+static void check_range (struct block *block, block_sector_t sector,
+                         size_t cnt)
+{
+  if (cnt > block->size || sector > block->size - cnt)
+    PANIC ("Access past end of device %s (sector=%" PRDSNu ", count=%zu, "
+           "size=%" PRDSNu ")\n",
+           block_name (block), sector, cnt, block->size);
+}
+
+/* Reads CNT sectors starting at SECTOR from BLOCK into BUFFER,
+   using the driver's multi-sector operation if it has one.
+   The caller must have checked the range. */
+static void do_read (struct block *block, block_sector_t sector, size_t cnt,
+                     void *buffer_)
+{
+  uint8_t *buffer = buffer_;
+
+  if (block->ops->read_multiple != NULL)
+    block->ops->read_multiple (block->aux, sector, cnt, buffer);
+  else
+    for (; cnt > 0; cnt--, sector++, buffer += BLOCK_SECTOR_SIZE)
+      block->ops->read (block->aux, sector, buffer);
+}
+
+/* Writes CNT sectors starting at SECTOR to BLOCK from BUFFER,
+   using the driver's multi-sector operation if it has one.
+   The caller must have checked the range. */
+static void do_write (struct block *block, block_sector_t sector, size_t cnt,
+                      const void *buffer_)
+{
+  const uint8_t *buffer = buffer_;
+
+  if (block->ops->write_multiple != NULL)
+    block->ops->write_multiple (block->aux, sector, cnt, buffer);
+  else
+    for (; cnt > 0; cnt--, sector++, buffer += BLOCK_SECTOR_SIZE)
+      block->ops->write (block->aux, sector, buffer);
+}
+
 /* Reads sector SECTOR from BLOCK into BUFFER, which must
    have room for BLOCK_SECTOR_SIZE bytes.
    Internally synchronizes accesses to block devices, so external
@@ -126,6 +167,64 @@ void block_write (struct block *block, block_sector_t sector,
   block->write_cnt++;
 }
 
+/* Reads CNT consecutive sectors starting at SECTOR from BLOCK
+   into BUFFER, which must have room for CNT * BLOCK_SECTOR_SIZE
+   bytes.  Drivers that support it transfer all of the sectors
+   in a single request.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void block_read_multiple (struct block *block, block_sector_t sector,
+                          size_t cnt, void *buffer)
+{
+  check_range (block, sector, cnt);
+  do_read (block, sector, cnt, buffer);
+  block->read_cnt += cnt;
+}
+
+/* Writes CNT consecutive sectors starting at SECTOR to BLOCK
+   from BUFFER, which must contain CNT * BLOCK_SECTOR_SIZE
+   bytes.  Returns after the block device has acknowledged
+   receiving all of the data.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void block_write_multiple (struct block *block, block_sector_t sector,
+                           size_t cnt, const void *buffer)
+{
+  check_range (block, sector, cnt);
+  ASSERT (block->type != BLOCK_FOREIGN);
+  do_write (block, sector, cnt, buffer);
+  block->write_cnt += cnt;
+}
+
+/* Starts the transfer described by REQ on BLOCK.  REQ's done
+   function is called when the transfer is complete; until then,
+   REQ and its buffer must not be modified or freed, and REQ's
+   SECTOR member is not meaningful.  If BLOCK's driver cannot do
+   asynchronous I/O, the transfer is done synchronously and
+   REQ->done is called before this function returns. */
+void block_submit (struct block *block, struct block_request *req)
+{
+  check_range (block, req->sector, req->cnt);
+  if (req->write)
+    {
+      ASSERT (block->type != BLOCK_FOREIGN);
+      block->write_cnt += req->cnt;
+    }
+  else
+    block->read_cnt += req->cnt;
+
+  if (block->ops->submit != NULL)
+    block->ops->submit (block->aux, req);
+  else
+    {
+      if (req->write)
+        do_write (block, req->sector, req->cnt, req->buffer);
+      else
+        do_read (block, req->sector, req->cnt, req->buffer);
+      req->done (req);
+    }
+}
+
 /* Returns the number of sectors in BLOCK. */
 block_sector_t block_size (struct block *block) { return block->size; }
 
@@ -1,6 +1,7 @@
 #ifndef DEVICES_BLOCK_H
 #define DEVICES_BLOCK_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <inttypes.h>
 
@@ -53,9 +54,30 @@ struct block *block_next (struct block *);
 block_sector_t block_size (struct block *);
 void block_read (struct block *, block_sector_t, void *);
 void block_write (struct block *, block_sector_t, const void *);
+void block_read_multiple (struct block *, block_sector_t, size_t cnt,
+                          void *);
+void block_write_multiple (struct block *, block_sector_t, size_t cnt,
+                           const void *);
 const char *block_name (struct block *);
 enum block_type block_type (struct block *);
 
+/* An asynchronous request to transfer CNT consecutive sectors
+   starting at SECTOR.  See block_submit(). */
+struct block_request
+{
+  bool write;            /* True to write BUFFER, false to read it. */
+  block_sector_t sector; /* First sector. */
+  size_t cnt;            /* Number of sectors. */
+  void *buffer;          /* CNT * BLOCK_SECTOR_SIZE bytes of data. */
+
+  /* Called once the transfer is complete.  May be called before
+     block_submit() returns, or later from another thread. */
+  void (*done) (struct block_request *);
+  void *aux; /* For use by the submitter. */
+};
+
+void block_submit (struct block *, struct block_request *);
+
 /* Statistics. */
 void block_print_stats (void);
 
@@ -65,6 +87,20 @@ struct block_operations
 {
   void (*read) (void *aux, block_sector_t, void *buffer);
   void (*write) (void *aux, block_sector_t, const void *buffer);
+
+  /* The rest are optional; drivers that leave them null get a
+     fallback built on READ and WRITE.  The block layer checks
+     the whole range of sectors before calling any of them. */
+
+  /* Transfer CNT consecutive sectors in a single request. */
+  void (*read_multiple) (void *aux, block_sector_t, size_t cnt, void *buffer);
+  void (*write_multiple) (void *aux, block_sector_t, size_t cnt,
+                          const void *buffer);
+
+  /* Starts the transfer described by the request and returns
+     without waiting for it to finish.  The driver may modify the
+     request's SECTOR member. */
+  void (*submit) (void *aux, struct block_request *);
 };
 
 struct block *block_register (const char *name, enum block_type,
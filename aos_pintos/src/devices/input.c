@@ -6,8 +6,16 @@
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+/* Serializes threads reading from BUFFER, which may have only one
+   consumer at a time. */
+static struct lock readers;
+
 /* Initializes the input buffer. */
-void input_init (void) { intq_init (&buffer); }
+void input_init (void)
+{
+  intq_init (&buffer);
+  lock_init (&readers);
+}
 
 /* Adds a key to the input buffer.
    Interrupts must be off and the buffer must not be full. */
@@ -21,25 +29,41 @@ void input_putc (uint8_t key)
 }
 
 /* Retrieves a key from the input buffer.
-   If the buffer is empty, waits for a key to be pressed. */
+   If the buffer is empty, waits for a key to be pressed.
+
+   Keys are added only by interrupt handlers, so the buffer has a
+   single producer, and removing a key requires only excluding
+   other readers, not turning off interrupts.  We turn them off
+   only if the buffer was full, in which case the serial port may
+   have stopped receiving and must be told there is room again.
+
+   Whether the buffer was full is judged without synchronizing
+   with the producer.  If it was full before our pop, it stayed
+   full up to the pop, because the producer can't add to a full
+   buffer and we are its only consumer.  If it only filled up
+   between our check and our pop, then it is at least one short
+   of full afterward, so the second test catches that case.
+   Either test may also fire when the producer added keys after
+   the pop, which only costs a redundant notification. */
 uint8_t input_getc (void)
 {
-  enum intr_level old_level;
+  bool was_full;
   uint8_t key;
 
-  old_level = intr_disable ();
+  lock_acquire (&readers);
+  was_full = intq_full (&buffer);
   key = intq_getc (&buffer);
-  serial_notify ();
-  intr_set_level (old_level);
+  lock_release (&readers);
+  if (was_full || ring_count (&buffer.ring) >= INTQ_BUFSIZE - 1)
+    {
+      enum intr_level old_level = intr_disable ();
+      serial_notify ();
+      intr_set_level (old_level);
+    }
 
   return key;
 }
 
 /* Returns true if the input buffer is full,
-   false otherwise.
-   Interrupts must be off. */
-bool input_full (void)
-{
-  ASSERT (intr_get_level () == INTR_OFF);
-  return intq_full (&buffer);
-}
+   false otherwise. */
+bool input_full (void) { return intq_full (&buffer); }
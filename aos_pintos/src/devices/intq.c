@@ -2,7 +2,6 @@
 #include <debug.h>
 #include "threads/thread.h"
 
-static int next (int pos);
 static void wait (struct intq *q, struct thread **waiter);
 static void signal (struct intq *q, struct thread **waiter);
 
@@ -11,22 +10,14 @@ void intq_init (struct intq *q)
 {
   lock_init (&q->lock);
   q->not_full = q->not_empty = NULL;
-  q->head = q->tail = 0;
+  ring_init (&q->ring, q->buf, sizeof q->buf);
 }
 
 /* Returns true if Q is empty, false otherwise. */
-bool intq_empty (const struct intq *q)
-{
-  ASSERT (intr_get_level () == INTR_OFF);
-  return q->head == q->tail;
-}
+bool intq_empty (const struct intq *q) { return ring_empty (&q->ring); }
 
 /* Returns true if Q is full, false otherwise. */
-bool intq_full (const struct intq *q)
-{
-  ASSERT (intr_get_level () == INTR_OFF);
-  return next (q->head) == q->tail;
-}
+bool intq_full (const struct intq *q) { return ring_full (&q->ring); }
 
 /* Removes a byte from Q and returns it.
    If Q is empty, sleeps until a byte is added.
@@ -35,18 +26,13 @@ uint8_t intq_getc (struct intq *q)
 {
   uint8_t byte;
 
-  ASSERT (intr_get_level () == INTR_OFF);
-  while (intq_empty (q))
+  while (intq_get (q, &byte, 1) == 0)
     {
       ASSERT (!intr_context ());
       lock_acquire (&q->lock);
       wait (q, &q->not_empty);
       lock_release (&q->lock);
     }
-
-  byte = q->buf[q->tail];
-  q->tail = next (q->tail);
-  signal (q, &q->not_full);
   return byte;
 }
 
@@ -55,49 +41,78 @@ uint8_t intq_getc (struct intq *q)
    When called from an interrupt handler, Q must not be full. */
 void intq_putc (struct intq *q, uint8_t byte)
 {
-  ASSERT (intr_get_level () == INTR_OFF);
-  while (intq_full (q))
+  while (intq_put (q, &byte, 1) == 0)
     {
       ASSERT (!intr_context ());
       lock_acquire (&q->lock);
       wait (q, &q->not_full);
       lock_release (&q->lock);
     }
+}
 
-  q->buf[q->head] = byte;
-  q->head = next (q->head);
-  signal (q, &q->not_empty);
+/* Removes up to CNT bytes from Q into BUFFER, without sleeping,
+   and returns the number of bytes removed. */
+size_t intq_get (struct intq *q, void *buffer, size_t cnt)
+{
+  cnt = ring_get (&q->ring, buffer, cnt);
+  if (cnt > 0)
+    signal (q, &q->not_full);
+  return cnt;
 }
 
-/* Returns the position after POS within an intq. */
-static int next (int pos) { return (pos + 1) % INTQ_BUFSIZE; }
+/* Adds up to CNT bytes from BUFFER to the end of Q, without
+   sleeping, and returns the number of bytes added. */
+size_t intq_put (struct intq *q, const void *buffer, size_t cnt)
+{
+  cnt = ring_put (&q->ring, buffer, cnt);
+  if (cnt > 0)
+    signal (q, &q->not_empty);
+  return cnt;
+}
 
 /* WAITER must be the address of Q's not_empty or not_full
-   member.  Waits until the given condition is true. */
-static void wait (struct intq *q UNUSED, struct thread **waiter)
+   member.  Waits until the given condition is true.
+
+   Interrupts are turned off so that the other side cannot
+   change the queue, and fail to see *WAITER, between our check
+   of the condition and our going to sleep. */
+static void wait (struct intq *q, struct thread **waiter)
 {
+  enum intr_level old_level;
+
   ASSERT (!intr_context ());
-  ASSERT (intr_get_level () == INTR_OFF);
-  ASSERT ((waiter == &q->not_empty && intq_empty (q)) ||
-          (waiter == &q->not_full && intq_full (q)));
+  ASSERT (waiter == &q->not_empty || waiter == &q->not_full);
 
-  *waiter = thread_current ();
-  thread_block ();
+  old_level = intr_disable ();
+  if (waiter == &q->not_empty ? intq_empty (q) : intq_full (q))
+    {
+      *waiter = thread_current ();
+      thread_block ();
+    }
+  intr_set_level (old_level);
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
    member, and the associated condition must be true.  If a
    thread is waiting for the condition, wakes it up and resets
-   the waiting thread. */
+   the waiting thread.
+
+   The common case, with nobody waiting, needs only a barrier:
+   a waiter records itself with interrupts off, after checking
+   the condition, so if we see no waiter here, any thread that
+   goes on to wait will see the update we just made to the
+   ring. */
 static void signal (struct intq *q UNUSED, struct thread **waiter)
 {
-  ASSERT (intr_get_level () == INTR_OFF);
-  ASSERT ((waiter == &q->not_empty && !intq_empty (q)) ||
-          (waiter == &q->not_full && !intq_full (q)));
-
+  barrier ();
   if (*waiter != NULL)
     {
-      thread_unblock (*waiter);
-      *waiter = NULL;
+      enum intr_level old_level = intr_disable ();
+      if (*waiter != NULL)
+        {
+          thread_unblock (*waiter);
+          *waiter = NULL;
+        }
+      intr_set_level (old_level);
     }
 }
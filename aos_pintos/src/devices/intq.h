@@ -1,23 +1,29 @@
 #ifndef DEVICES_INTQ_H
 #define DEVICES_INTQ_H
 
+#include <ring.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
 
 /* An "interrupt queue", a circular buffer shared between
    kernel threads and external interrupt handlers.
 
-   Interrupt queue functions can be called from kernel threads or
-   from external interrupt handlers.  Except for intq_init(),
-   interrupts must be off in either case.
-
-   The interrupt queue has the structure of a "monitor".  Locks
-   and condition variables from threads/synch.h cannot be used in
-   this case, as they normally would, because they can only
-   protect kernel threads from one another, not from interrupt
-   handlers. */
-
-/* Queue buffer size, in bytes. */
+   The queue is a single-producer, single-consumer ring (see
+   lib/kernel/ring.h): at any time one thread of control may add
+   bytes and another may remove them.  Either side may be a
+   kernel thread or an external interrupt handler.  If several
+   threads of control may produce (or consume), the caller must
+   serialize them, e.g. by turning interrupts off.
+
+   Adding or removing bytes does not require interrupts to be
+   off.  Interrupts are turned off only briefly, to put a thread
+   to sleep when it must wait for the queue to become non-empty
+   or non-full, or to wake such a thread up.  Locks and condition
+   variables from threads/synch.h cannot be used for that, as
+   they normally would, because they can only protect kernel
+   threads from one another, not from interrupt handlers. */
+
+/* Queue buffer size, in bytes.  Must be a power of 2. */
 #define INTQ_BUFSIZE 64
 
 /* A circular queue of bytes. */
@@ -29,9 +35,8 @@ struct intq
   struct thread *not_empty; /* Thread waiting for not-empty condition. */
 
   /* Queue. */
+  struct ring ring;          /* Ring buffer over BUF. */
   uint8_t buf[INTQ_BUFSIZE]; /* Buffer. */
-  int head;                  /* New data is written here. */
-  int tail;                  /* Old data is read here. */
 };
 
 void intq_init (struct intq *);
@@ -39,5 +44,7 @@ bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
 uint8_t intq_getc (struct intq *);
 void intq_putc (struct intq *, uint8_t);
+size_t intq_get (struct intq *, void *, size_t cnt);
+size_t intq_put (struct intq *, const void *, size_t cnt);
 
 #endif /* devices/intq.h */
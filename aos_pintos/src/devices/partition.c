@@ -311,5 +311,36 @@ static void partition_write (void *p_, block_sector_t sector,
   block_write (p->block, p->start + sector, buffer);
 }
 
-static struct block_operations partition_operations = {partition_read,
-                                                       partition_write};
+/* Reads CNT sectors starting at SECTOR from partition P into
+   BUFFER, passing the whole request through to the underlying
+   device so that it can use its multi-sector fast path. */
+static void partition_read_multiple (void *p_, block_sector_t sector,
+                                     size_t cnt, void *buffer)
+{
+  struct partition *p = p_;
+  block_read_multiple (p->block, p->start + sector, cnt, buffer);
+}
+
+/* Writes CNT sectors starting at SECTOR to partition P from
+   BUFFER, passing the whole request through to the underlying
+   device. */
+static void partition_write_multiple (void *p_, block_sector_t sector,
+                                      size_t cnt, const void *buffer)
+{
+  struct partition *p = p_;
+  block_write_multiple (p->block, p->start + sector, cnt, buffer);
+}
+
+/* Starts REQ on partition P by translating its starting sector
+   and handing it to the underlying device. */
+static void partition_submit (void *p_, struct block_request *req)
+{
+  struct partition *p = p_;
+  req->sector += p->start;
+  block_submit (p->block, req);
+}
+
+static struct block_operations partition_operations = {
+    partition_read,           partition_write,  partition_read_multiple,
+    partition_write_multiple, partition_submit,
+};
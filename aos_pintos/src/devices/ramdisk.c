@@ -0,0 +1,178 @@
+#include "devices/ramdisk.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A RAM disk is a block device whose sectors live in kernel
+   memory.  It is useful for measuring file system code without
+   the cost of emulated IDE transfers, and for keeping scratch
+   data that does not need to survive a reboot.
+
+   The backing store is allocated one page at a time from the
+   kernel pool, so a large RAM disk does not need physically
+   contiguous memory. */
+
+/* Number of sectors in each backing page. */
+#define SECTORS_PER_PAGE (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* A RAM disk. */
+struct ramdisk
+{
+  block_sector_t size; /* Size in sectors. */
+  size_t page_cnt;     /* Number of backing pages. */
+  uint8_t **pages;     /* Backing pages. */
+};
+
+static struct block_operations ramdisk_operations;
+
+static void ramdisk_free (struct ramdisk *);
+
+/* Creates a RAM disk named "rd0" with SIZE sectors and
+   registers it with the block layer as a raw device.
+
+   If SOURCE is non-null, the RAM disk is filled with the
+   contents of SOURCE, and a SIZE of 0 means to make the RAM
+   disk the same size as SOURCE.  Any part of the RAM disk past
+   the end of SOURCE is zeroed.
+
+   Prints a message and does not create the RAM disk if there is
+   not enough kernel memory for it. */
+void ramdisk_init (block_sector_t size, struct block *source)
+{
+  struct ramdisk *rd;
+  char extra_info[128];
+  block_sector_t sector;
+  size_t i;
+
+  if (source != NULL && size == 0)
+    size = block_size (source);
+  if (size == 0)
+    return;
+
+  rd = malloc (sizeof *rd);
+  if (rd == NULL)
+    PANIC ("Failed to allocate memory for RAM disk descriptor");
+  rd->size = size;
+  rd->page_cnt = DIV_ROUND_UP (size, SECTORS_PER_PAGE);
+  rd->pages = calloc (rd->page_cnt, sizeof *rd->pages);
+  if (rd->pages == NULL)
+    PANIC ("Failed to allocate memory for RAM disk page map");
+
+  for (i = 0; i < rd->page_cnt; i++)
+    {
+      rd->pages[i] = palloc_get_page (PAL_ZERO);
+      if (rd->pages[i] == NULL)
+        {
+          printf ("rd0: not enough kernel memory for ");
+          print_human_readable_size ((uint64_t) size * BLOCK_SECTOR_SIZE);
+          printf (" RAM disk\n");
+          ramdisk_free (rd);
+          return;
+        }
+    }
+
+  if (source != NULL)
+    {
+      block_sector_t copy_cnt =
+          size < block_size (source) ? size : block_size (source);
+      for (sector = 0; sector < copy_cnt; sector += SECTORS_PER_PAGE)
+        {
+          size_t run = copy_cnt - sector;
+          if (run > SECTORS_PER_PAGE)
+            run = SECTORS_PER_PAGE;
+          block_read_multiple (source, sector, run,
+                               rd->pages[sector / SECTORS_PER_PAGE]);
+        }
+      snprintf (extra_info, sizeof extra_info, "RAM disk, copy of %s",
+                block_name (source));
+    }
+  else
+    strlcpy (extra_info, "RAM disk", sizeof extra_info);
+
+  block_register ("rd0", BLOCK_RAW, extra_info, size, &ramdisk_operations, rd);
+}
+
+/* Frees RD and whatever backing pages it has. */
+static void ramdisk_free (struct ramdisk *rd)
+{
+  size_t i;
+
+  for (i = 0; i < rd->page_cnt; i++)
+    palloc_free_page (rd->pages[i]);
+  free (rd->pages);
+  free (rd);
+}
+
+/* Returns the address of SECTOR within RD. */
+static uint8_t *sector_addr (const struct ramdisk *rd, block_sector_t sector)
+{
+  ASSERT (sector < rd->size);
+  return (rd->pages[sector / SECTORS_PER_PAGE] +
+          sector % SECTORS_PER_PAGE * BLOCK_SECTOR_SIZE);
+}
+
+/* Reads sector SECTOR from RAM disk RD into BUFFER, which must
+   have room for BLOCK_SECTOR_SIZE bytes. */
+static void ramdisk_read (void *rd_, block_sector_t sector, void *buffer)
+{
+  struct ramdisk *rd = rd_;
+  memcpy (buffer, sector_addr (rd, sector), BLOCK_SECTOR_SIZE);
+}
+
+/* Writes sector SECTOR to RAM disk RD from BUFFER, which must
+   contain BLOCK_SECTOR_SIZE bytes. */
+static void ramdisk_write (void *rd_, block_sector_t sector,
+                           const void *buffer)
+{
+  struct ramdisk *rd = rd_;
+  memcpy (sector_addr (rd, sector), buffer, BLOCK_SECTOR_SIZE);
+}
+
+/* Reads CNT sectors starting at SECTOR from RAM disk RD into
+   BUFFER, copying a page's worth of sectors at a time. */
+static void ramdisk_read_multiple (void *rd_, block_sector_t sector,
+                                   size_t cnt, void *buffer_)
+{
+  struct ramdisk *rd = rd_;
+  uint8_t *buffer = buffer_;
+
+  while (cnt > 0)
+    {
+      size_t run = SECTORS_PER_PAGE - sector % SECTORS_PER_PAGE;
+      if (run > cnt)
+        run = cnt;
+      memcpy (buffer, sector_addr (rd, sector), run * BLOCK_SECTOR_SIZE);
+      buffer += run * BLOCK_SECTOR_SIZE;
+      sector += run;
+      cnt -= run;
+    }
+}
+
+/* Writes CNT sectors starting at SECTOR to RAM disk RD from
+   BUFFER, copying a page's worth of sectors at a time. */
+static void ramdisk_write_multiple (void *rd_, block_sector_t sector,
+                                    size_t cnt, const void *buffer_)
+{
+  struct ramdisk *rd = rd_;
+  const uint8_t *buffer = buffer_;
+
+  while (cnt > 0)
+    {
+      size_t run = SECTORS_PER_PAGE - sector % SECTORS_PER_PAGE;
+      if (run > cnt)
+        run = cnt;
+      memcpy (sector_addr (rd, sector), buffer, run * BLOCK_SECTOR_SIZE);
+      buffer += run * BLOCK_SECTOR_SIZE;
+      sector += run;
+      cnt -= run;
+    }
+}
+
+static struct block_operations ramdisk_operations = {
+    ramdisk_read,           ramdisk_write,          ramdisk_read_multiple,
+    ramdisk_write_multiple, NULL,
+};
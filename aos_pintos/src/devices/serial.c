@@ -37,6 +37,16 @@
 #define IER_RECV 0x01 /* Interrupt when data received. */
 #define IER_XMIT 0x02 /* Interrupt when transmit finishes. */
 
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01   /* Enable transmit and receive FIFOs. */
+#define FCR_CLEAR_RX 0x02 /* Clear receive FIFO. */
+#define FCR_CLEAR_TX 0x04 /* Clear transmit FIFO. */
+
+/* Size of the 16550A's transmit FIFO, in bytes.  When LSR_THRE
+   is set, the whole FIFO is empty and this many bytes may be
+   written to THR_REG without waiting. */
+#define TX_FIFO_SIZE 16
+
 /* Line Control Register bits. */
 #define LCR_N81 0x03  /* No parity, 8 data bits, 1 stop bit. */
 #define LCR_DLAB 0x80 /* Divisor Latch Access Bit (DLAB). */
@@ -51,11 +61,19 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
+/* Data to be transmitted.
+
+   Any kernel thread, and any interrupt handler that prints, may
+   add to the queue, so producers turn off interrupts to take
+   turns.  Bytes are removed only by the serial interrupt handler
+   and by polling code that runs with interrupts off, so the
+   consumer side needs no further locking. */
 static struct intq txq;
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
+static void fill_fifo_poll (void);
+static void fill_fifo (void);
 static void write_ier (void);
 static intr_handler_func serial_interrupt;
 
@@ -67,7 +85,7 @@ static void init_poll (void)
 {
   ASSERT (mode == UNINIT);
   outb (IER_REG, 0);        /* Turn off all interrupts. */
-  outb (FCR_REG, 0);        /* Disable FIFO. */
+  outb (FCR_REG, FCR_ENABLE | FCR_CLEAR_RX | FCR_CLEAR_TX);
   set_serial (9600);        /* 9.6 kbps, N-8-1. */
   outb (MCR_REG, MCR_OUT2); /* Required to enable interrupts. */
   intq_init (&txq);
@@ -126,13 +144,70 @@ void serial_putc (uint8_t byte)
   intr_set_level (old_level);
 }
 
+/* Sends the N bytes in BUFFER to the serial port.  This is
+   equivalent to calling serial_putc() on each byte, but turns
+   off interrupts only once for the whole buffer and, if it has
+   to make room in the transmit queue by polling, sends a whole
+   FIFO's worth of bytes per wait instead of one. */
+void serial_write (const void *buffer_, size_t n)
+{
+  const uint8_t *buffer = buffer_;
+  enum intr_level old_level = intr_disable ();
+
+  if (mode != QUEUE)
+    {
+      if (mode == UNINIT)
+        init_poll ();
+      while (n > 0)
+        {
+          size_t i;
+
+          while ((inb (LSR_REG) & LSR_THRE) == 0)
+            continue;
+          for (i = 0; i < TX_FIFO_SIZE && n > 0; i++, n--)
+            outb (THR_REG, *buffer++);
+        }
+    }
+  else
+    {
+      while (n > 0)
+        {
+          size_t cnt = intq_put (&txq, buffer, n);
+          buffer += cnt;
+          n -= cnt;
+          if (n == 0)
+            break;
+
+          if (old_level == INTR_OFF)
+            {
+              /* As in serial_putc(), we can't wait for the
+                 interrupt handler to drain the queue, so drain a
+                 FIFO load ourselves. */
+              fill_fifo_poll ();
+            }
+          else
+            {
+              /* Make sure the transmit interrupt is enabled, then
+                 sleep in intq_putc() until the interrupt handler
+                 makes room. */
+              write_ier ();
+              intq_putc (&txq, *buffer++);
+              n--;
+            }
+        }
+      write_ier ();
+    }
+
+  intr_set_level (old_level);
+}
+
 /* Flushes anything in the serial buffer out the port in polling
    mode. */
 void serial_flush (void)
 {
   enum intr_level old_level = intr_disable ();
   while (!intq_empty (&txq))
-    putc_poll (intq_getc (&txq));
+    fill_fifo_poll ();
   intr_set_level (old_level);
 }
 
@@ -197,6 +272,29 @@ static void putc_poll (uint8_t byte)
   outb (THR_REG, byte);
 }
 
+/* Polls the serial port until its transmit FIFO is empty, and
+   then refills the FIFO from the transmit queue. */
+static void fill_fifo_poll (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while ((inb (LSR_REG) & LSR_THRE) == 0)
+    continue;
+  fill_fifo ();
+}
+
+/* Moves up to a FIFO's worth of bytes from the transmit queue to
+   the UART.  The transmit FIFO must be empty. */
+static void fill_fifo (void)
+{
+  uint8_t fifo[TX_FIFO_SIZE];
+  size_t cnt, i;
+
+  cnt = intq_get (&txq, fifo, sizeof fifo);
+  for (i = 0; i < cnt; i++)
+    outb (THR_REG, fifo[i]);
+}
+
 /* Serial interrupt handler. */
 static void serial_interrupt (struct intr_frame *f UNUSED)
 {
@@ -209,10 +307,11 @@ static void serial_interrupt (struct intr_frame *f UNUSED)
   while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
     input_putc (inb (RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0)
-    outb (THR_REG, intq_getc (&txq));
+  /* If the hardware's transmit FIFO is empty, refill it from the
+     transmit queue.  THRE only tells us that the whole FIFO is
+     empty, so fill it without checking THRE between bytes. */
+  if (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0)
+    fill_fifo ();
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
@@ -8,6 +8,8 @@
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
@@ -50,6 +52,7 @@ void shutdown_configure (enum shutdown_type type) { how = type; }
 /* Reboots the machine via the keyboard controller. */
 void shutdown_reboot (void)
 {
+  console_flush ();
   printf ("Rebooting...\n");
 
   /* See [kbd] for details on how to program the keyboard
@@ -83,6 +86,10 @@ void shutdown_power_off (void)
   const char s[] = "Shutdown";
   const char *p;
 
+  /* Write out the running thread's partial line, if any, which
+     would otherwise be lost, since the thread never exits. */
+  console_flush ();
+
 #ifdef FILESYS
   filesys_done ();
 #endif
@@ -131,5 +138,7 @@ static void print_stats (void)
   kbd_print_stats ();
 #ifdef USERPROG
   exception_print_stats ();
+  pagedir_print_stats ();
+  process_print_stats ();
 #endif
 }
@@ -29,6 +29,8 @@ static uint8_t (*fb)[COL_CNT][2];
 static void clear_row (size_t y);
 static void cls (void);
 static void newline (void);
+static void scroll (size_t rows);
+static void advance (int c, int *x, int *y);
 static void move_cursor (void);
 static void find_cursor (size_t *x, size_t *y);
 
@@ -100,6 +102,105 @@ void vga_putc (int c)
   intr_set_level (old_level);
 }
 
+/* Writes the N characters in BUFFER to the VGA text display.
+   The result is the same as calling vga_putc() on each of them,
+   but the screen is scrolled at most once and the hardware
+   cursor is moved only at the end. */
+void vga_write (const char *buffer, size_t n)
+{
+  enum intr_level old_level;
+  int x, y, excess;
+  size_t i;
+
+  /* Clearing the screen and beeping are rare enough that we just
+     let vga_putc() deal with them. */
+  if (memchr (buffer, '\f', n) != NULL || memchr (buffer, '\a', n) != NULL)
+    {
+      while (n-- > 0)
+        vga_putc (*buffer++);
+      return;
+    }
+
+  old_level = intr_disable ();
+
+  init ();
+
+  /* Find out how many lines past the bottom of the screen the
+     text extends, and scroll that far up front. */
+  x = cx;
+  y = cy;
+  for (i = 0; i < n; i++)
+    advance (buffer[i], &x, &y);
+  excess = y - (ROW_CNT - 1);
+  if (excess < 0)
+    excess = 0;
+  scroll (excess);
+
+  /* Now draw the text.  Rows above the top of the screen are
+     those that scrolled off, so text on them is dropped. */
+  x = cx;
+  y = (int) cy - excess;
+  for (i = 0; i < n; i++)
+    {
+      uint8_t c = buffer[i];
+
+      if (y >= 0 && c != '\n' && c != '\b' && c != '\r' && c != '\t')
+        {
+          fb[y][x][0] = c;
+          fb[y][x][1] = GRAY_ON_BLACK;
+        }
+      advance (c, &x, &y);
+    }
+  cx = x;
+  cy = y;
+
+  /* Update cursor position. */
+  move_cursor ();
+
+  intr_set_level (old_level);
+}
+
+/* Moves the cursor position (*X,*Y) past character C, which must
+   not be '\f' or '\a', the same way vga_putc() would but without
+   scrolling, so that *Y may end up past the bottom of the
+   screen. */
+static void advance (int c, int *x, int *y)
+{
+  switch (c)
+    {
+      case '\n':
+        *x = 0;
+        ++*y;
+        break;
+
+      case '\b':
+        if (*x > 0)
+          --*x;
+        break;
+
+      case '\r':
+        *x = 0;
+        break;
+
+      case '\t':
+        *x = ROUND_UP (*x + 1, 8);
+        if (*x >= COL_CNT)
+          {
+            *x = 0;
+            ++*y;
+          }
+        break;
+
+      default:
+        if (++*x >= COL_CNT)
+          {
+            *x = 0;
+            ++*y;
+          }
+        break;
+    }
+}
+
 /* Clears the screen and moves the cursor to the upper left. */
 static void cls (void)
 {
@@ -134,11 +235,25 @@ static void newline (void)
   if (cy >= ROW_CNT)
     {
       cy = ROW_CNT - 1;
-      memmove (&fb[0], &fb[1], sizeof fb[0] * (ROW_CNT - 1));
-      clear_row (ROW_CNT - 1);
+      scroll (1);
     }
 }
 
+/* Scrolls the screen upward ROWS lines, clearing the rows that
+   become exposed at the bottom.  Doesn't move the cursor. */
+static void scroll (size_t rows)
+{
+  size_t y;
+
+  if (rows == 0)
+    return;
+  if (rows > ROW_CNT)
+    rows = ROW_CNT;
+  memmove (&fb[0], &fb[rows], sizeof fb[0] * (ROW_CNT - rows));
+  for (y = ROW_CNT - rows; y < ROW_CNT; y++)
+    clear_row (y);
+}
+
 /* Moves the hardware cursor to (cx,cy). */
 static void move_cursor (void)
 {
@@ -0,0 +1,78 @@
+/* writev-bench.c
+
+   Compares the cost of writing RECORD_CNT small records to a file
+   with one write() per record against writing them all with a
+   single writev().  Times are in CPU cycles, as counted by the
+   time-stamp counter.
+
+   Usage: writev-bench [FILE] */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Number of records, and the size of each. */
+#define RECORD_CNT 1000
+#define RECORD_SIZE 16
+
+static char records[RECORD_CNT][RECORD_SIZE];
+static struct iovec iov[RECORD_CNT];
+
+/* Returns the time-stamp counter. */
+static inline uint64_t rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+int main (int argc, char *argv[])
+{
+  const char *name = argc > 1 ? argv[1] : "writev.out";
+  uint64_t start, write_cycles, writev_cycles;
+  int fd, i, total = 0;
+
+  for (i = 0; i < RECORD_CNT; i++)
+    {
+      snprintf (records[i], RECORD_SIZE, "record %7d\n", i);
+      iov[i].iov_base = records[i];
+      iov[i].iov_len = strlen (records[i]);
+      total += iov[i].iov_len;
+    }
+
+  if (!create (name, 0))
+    {
+      printf ("%s: create failed\n", name);
+      return EXIT_FAILURE;
+    }
+  fd = open (name);
+  if (fd < 0)
+    {
+      printf ("%s: open failed\n", name);
+      return EXIT_FAILURE;
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < RECORD_CNT; i++)
+    if (write (fd, iov[i].iov_base, iov[i].iov_len) != (int) iov[i].iov_len)
+      {
+        printf ("%s: write failed\n", name);
+        return EXIT_FAILURE;
+      }
+  write_cycles = rdtsc () - start;
+
+  seek (fd, 0);
+  start = rdtsc ();
+  if (writev (fd, iov, RECORD_CNT) != total)
+    {
+      printf ("%s: writev failed\n", name);
+      return EXIT_FAILURE;
+    }
+  writev_cycles = rdtsc () - start;
+
+  printf ("%d writes: %llu cycles\n", RECORD_CNT, write_cycles);
+  printf ("1 writev:    %llu cycles\n", writev_cycles);
+  close (fd);
+  return EXIT_SUCCESS;
+}
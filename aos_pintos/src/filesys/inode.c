@@ -36,6 +36,7 @@ struct inode
   int open_cnt;           /* Number of openers. */
   bool removed;           /* True if deleted, false otherwise. */
   int deny_write_cnt;     /* 0: writes ok, >0: deny writes. */
+  unsigned version;       /* Changes when data is written. */
   struct inode_disk data; /* Inode content. */
 };
 
@@ -56,6 +57,9 @@ static block_sector_t byte_to_sector (const struct inode *inode, off_t pos)
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Next inode version to hand out.  See inode_get_version(). */
+static unsigned next_version;
+
 /* Initializes the inode module. */
 void inode_init (void) { list_init (&open_inodes); }
 
@@ -131,6 +135,7 @@ struct inode *inode_open (block_sector_t sector)
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
+  inode->version = next_version++;
   block_read (fs_device, inode->sector, &inode->data);
   return inode;
 }
@@ -184,6 +189,13 @@ void inode_remove (struct inode *inode)
   inode->removed = true;
 }
 
+/* Returns true if INODE has been marked to be deleted by
+   inode_remove(). */
+bool inode_is_removed (const struct inode *inode)
+{
+  return inode->removed;
+}
+
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
    Returns the number of bytes actually read, which may be less
    than SIZE if an error occurs or end of file is reached. */
@@ -212,8 +224,15 @@ off_t inode_read_at (struct inode *inode, void *buffer_, off_t size,
 
       if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
         {
-          /* Read full sector directly into caller's buffer. */
-          block_read (fs_device, sector_idx, buffer + bytes_read);
+          /* Read as many full sectors as we can directly into
+             caller's buffer, in a single transfer.  A file's
+             sectors are contiguous on disk. */
+          off_t run = size < inode_left ? size : inode_left;
+          size_t sector_cnt = run / BLOCK_SECTOR_SIZE;
+
+          block_read_multiple (fs_device, sector_idx, sector_cnt,
+                               buffer + bytes_read);
+          chunk_size = sector_cnt * BLOCK_SECTOR_SIZE;
         }
       else
         {
@@ -272,8 +291,14 @@ off_t inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
       if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
         {
-          /* Write full sector directly to disk. */
-          block_write (fs_device, sector_idx, buffer + bytes_written);
+          /* Write as many full sectors as we can directly to
+             disk, in a single transfer, as in inode_read_at(). */
+          off_t run = size < inode_left ? size : inode_left;
+          size_t sector_cnt = run / BLOCK_SECTOR_SIZE;
+
+          block_write_multiple (fs_device, sector_idx, sector_cnt,
+                                buffer + bytes_written);
+          chunk_size = sector_cnt * BLOCK_SECTOR_SIZE;
         }
       else
         {
@@ -303,6 +328,9 @@ off_t inode_write_at (struct inode *inode, const void *buffer_, off_t size,
     }
   free (bounce);
 
+  if (bytes_written > 0)
+    inode->version = next_version++;
+
   return bytes_written;
 }
 
@@ -327,6 +355,17 @@ void inode_allow_write (struct inode *inode)
 /* Returns the length, in bytes, of INODE's data. */
 off_t inode_length (const struct inode *inode) { return inode->data.length; }
 
+/* Returns INODE's version.  The version changes whenever data is
+   written to INODE, and no two inodes opened since boot ever
+   have the same version, so data read from an inode can be
+   cached under its version and reused for as long as the version
+   stays the same.  An inode that is closed by every opener and
+   then opened again gets a new version. */
+unsigned inode_get_version (const struct inode *inode)
+{
+  return inode->version;
+}
+
 bool inode_get_symlink (struct inode *inode) { 
   ASSERT (inode != NULL);
   return inode->data.is_symlink; 
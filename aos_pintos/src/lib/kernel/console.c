@@ -1,14 +1,23 @@
 #include <console.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "devices/serial.h"
 #include "devices/vga.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 static void vprintf_helper (char, void *);
+static void line_vprintf_helper (char, void *);
 static void putchar_have_lock (uint8_t c);
+static void write_have_lock (const char *, size_t);
+static bool use_line_buffer (void);
+static struct console_line *current_line (void);
+static void line_putc (struct console_line *, char);
+static void flush_line (struct console_line *);
 
 /* The console lock.
    Both the vga and serial layers do their own locking, so it's
@@ -68,8 +77,33 @@ void console_init (void)
 
 /* Notifies the console that a kernel panic is underway,
    which warns it to avoid trying to take the console lock from
-   now on. */
-void console_panic (void) { use_console_lock = false; }
+   now on.  Any output the running thread has buffered is written
+   out immediately, so that it appears before the panic
+   message. */
+void console_panic (void)
+{
+  struct console_line *line;
+
+  if (!use_console_lock)
+    return;
+  use_console_lock = false;
+
+  /* The thread's stack may have overflowed into its line buffer,
+     so don't trust the length blindly. */
+  line = current_line ();
+  if (line->len <= sizeof line->buf)
+    write_have_lock (line->buf, line->len);
+  line->len = 0;
+}
+
+/* Writes out any console output that the running thread has
+   buffered.  Called when a thread exits and before the machine
+   shuts down, so that a partial last line isn't lost. */
+void console_flush (void)
+{
+  if (use_line_buffer ())
+    flush_line (current_line ());
+}
 
 /* Prints console statistics. */
 void console_print_stats (void)
@@ -109,16 +143,34 @@ static bool console_locked_by_current_thread (void)
           lock_held_by_current_thread (&console_lock));
 }
 
+/* Returns true if output from the running thread should go
+   through its line buffer.  Interrupt handlers have no thread of
+   their own, and output during early boot or a panic has to
+   appear right away, so they bypass it. */
+static bool use_line_buffer (void)
+{
+  return !intr_context () && use_console_lock;
+}
+
 /* The standard vprintf() function,
    which is like printf() but uses a va_list.
-   Writes its output to both vga display and serial port. */
+   Writes its output to both vga display and serial port.
+
+   Output from a thread is collected in the thread's line buffer,
+   without taking the console lock, and written out a line at a
+   time. */
 int vprintf (const char *format, va_list args)
 {
   int char_cnt = 0;
 
-  acquire_console ();
-  __vprintf (format, args, vprintf_helper, &char_cnt);
-  release_console ();
+  if (use_line_buffer ())
+    __vprintf (format, args, line_vprintf_helper, &char_cnt);
+  else
+    {
+      acquire_console ();
+      __vprintf (format, args, vprintf_helper, &char_cnt);
+      release_console ();
+    }
 
   return char_cnt;
 }
@@ -127,30 +179,50 @@ int vprintf (const char *format, va_list args)
    character. */
 int puts (const char *s)
 {
-  acquire_console ();
-  while (*s != '\0')
-    putchar_have_lock (*s++);
-  putchar_have_lock ('\n');
-  release_console ();
+  if (use_line_buffer ())
+    {
+      struct console_line *line = current_line ();
+      while (*s != '\0')
+        line_putc (line, *s++);
+      line_putc (line, '\n');
+    }
+  else
+    {
+      acquire_console ();
+      while (*s != '\0')
+        putchar_have_lock (*s++);
+      putchar_have_lock ('\n');
+      release_console ();
+    }
 
   return 0;
 }
 
-/* Writes the N characters in BUFFER to the console. */
+/* Writes the N characters in BUFFER to the console.
+   The whole buffer goes to the devices in one call, which lets
+   them batch it.  Anything in the running thread's line buffer
+   is written out first, to keep the output in order. */
 void putbuf (const char *buffer, size_t n)
 {
+  if (use_line_buffer ())
+    flush_line (current_line ());
+
   acquire_console ();
-  while (n-- > 0)
-    putchar_have_lock (*buffer++);
+  write_have_lock (buffer, n);
   release_console ();
 }
 
 /* Writes C to the vga display and serial port. */
 int putchar (int c)
 {
-  acquire_console ();
-  putchar_have_lock (c);
-  release_console ();
+  if (use_line_buffer ())
+    line_putc (current_line (), c);
+  else
+    {
+      acquire_console ();
+      putchar_have_lock (c);
+      release_console ();
+    }
 
   return c;
 }
@@ -163,6 +235,14 @@ static void vprintf_helper (char c, void *char_cnt_)
   putchar_have_lock (c);
 }
 
+/* Helper function for vprintf() when line buffering. */
+static void line_vprintf_helper (char c, void *char_cnt_)
+{
+  int *char_cnt = char_cnt_;
+  (*char_cnt)++;
+  line_putc (current_line (), c);
+}
+
 /* Writes C to the vga display and serial port.
    The caller has already acquired the console lock if
    appropriate. */
@@ -173,3 +253,56 @@ static void putchar_have_lock (uint8_t c)
   serial_putc (c);
   vga_putc (c);
 }
+
+/* Writes the N characters in BUFFER to the vga display and serial
+   port.  The caller has already acquired the console lock if
+   appropriate. */
+static void write_have_lock (const char *buffer, size_t n)
+{
+  ASSERT (console_locked_by_current_thread ());
+  write_cnt += n;
+  serial_write (buffer, n);
+  vga_write (buffer, n);
+}
+
+/* Returns the running thread's line buffer.
+
+   This finds the thread the same way running_thread() in
+   threads/thread.c does, without thread_current()'s sanity
+   checks, so that it is safe to use while panicking or from the
+   middle of a context switch. */
+static struct console_line *current_line (void)
+{
+  uint32_t *esp;
+
+  asm ("mov %%esp, %0" : "=g"(esp));
+  return &((struct thread *) pg_round_down (esp))->console;
+}
+
+/* Appends C to LINE, writing LINE out if C ends a line or LINE
+   is full. */
+static void line_putc (struct console_line *line, char c)
+{
+  line->buf[line->len++] = c;
+  if (c == '\n' || line->len >= sizeof line->buf)
+    flush_line (line);
+}
+
+/* Writes out the contents of LINE, which must belong to the
+   running thread, under a single acquisition of the console lock.
+   The contents are copied out first, in case something we call
+   while writing prints more. */
+static void flush_line (struct console_line *line)
+{
+  char buf[CONSOLE_LINE_SIZE];
+  size_t n = line->len;
+
+  if (n == 0)
+    return;
+  memcpy (buf, line->buf, n);
+  line->len = 0;
+
+  acquire_console ();
+  write_have_lock (buf, n);
+  release_console ();
+}
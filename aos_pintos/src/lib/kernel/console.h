@@ -1,8 +1,27 @@
 #ifndef __LIB_KERNEL_CONSOLE_H
 #define __LIB_KERNEL_CONSOLE_H
 
+#include <stddef.h>
+
+/* Size of a thread's console line buffer, in bytes.  The buffer
+   lives in struct thread, at the bottom of the thread's 4 kB
+   page, so every byte of it comes out of the room left for the
+   kernel stack.  One 80-column line is enough for nearly all
+   output; a longer line is simply written out in pieces. */
+#define CONSOLE_LINE_SIZE 80
+
+/* Console output that a thread has produced but not yet written
+   out.  It is written out when it reaches the end of a line or
+   fills up. */
+struct console_line
+{
+  size_t len;                  /* Number of bytes in BUF. */
+  char buf[CONSOLE_LINE_SIZE]; /* Pending output. */
+};
+
 void console_init (void);
 void console_panic (void);
+void console_flush (void);
 void console_print_stats (void);
 
 #endif /* lib/kernel/console.h */
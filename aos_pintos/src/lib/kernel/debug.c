@@ -12,6 +12,9 @@
 #include "threads/vaddr.h"
 #include "devices/serial.h"
 #include "devices/shutdown.h"
+#ifdef VM
+#include "vm/stats.h"
+#endif
 
 /* Halts the OS, printing the source file name, line number, and
    function name, plus a user-specific message. */
@@ -35,6 +38,9 @@ void debug_panic (const char *file, int line, const char *function,
       va_end (args);
 
       debug_backtrace ();
+#ifdef VM
+      vm_trace_dump ();
+#endif
     }
   else if (level == 2)
     printf ("Kernel PANIC recursion at %s:%d in %s().\n", file, line, function);
@@ -0,0 +1,99 @@
+#include "ring.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/synch.h"
+
+/* Initializes RING to use the SIZE bytes in BUF as its storage.
+   SIZE must be a power of 2. */
+void ring_init (struct ring *ring, void *buf, size_t size)
+{
+  ASSERT (ring != NULL);
+  ASSERT (buf != NULL);
+  ASSERT (size > 0 && (size & (size - 1)) == 0);
+
+  ring->buf = buf;
+  ring->mask = size - 1;
+  ring->head = ring->tail = 0;
+}
+
+/* Returns the number of bytes that RING can hold. */
+size_t ring_size (const struct ring *ring) { return ring->mask + 1; }
+
+/* Returns the number of bytes in RING.  If called by neither the
+   producer nor the consumer, the answer may be stale by the time
+   it is returned. */
+size_t ring_count (const struct ring *ring)
+{
+  return ring->head - ring->tail;
+}
+
+/* Returns the number of bytes that could be added to RING. */
+size_t ring_space (const struct ring *ring)
+{
+  return ring_size (ring) - ring_count (ring);
+}
+
+/* Returns true if RING is empty, false otherwise. */
+bool ring_empty (const struct ring *ring) { return ring->head == ring->tail; }
+
+/* Returns true if RING is full, false otherwise. */
+bool ring_full (const struct ring *ring)
+{
+  return ring_count (ring) == ring_size (ring);
+}
+
+/* Adds up to CNT bytes from BUF to RING, as many as there is room
+   for, and returns the number added.  Only the producer may call
+   this function. */
+size_t ring_put (struct ring *ring, const void *buf, size_t cnt)
+{
+  size_t head = ring->head;
+  size_t space = ring_size (ring) - (head - ring->tail);
+  size_t ofs = head & ring->mask;
+  size_t first;
+
+  if (cnt > space)
+    cnt = space;
+  if (cnt == 0)
+    return 0;
+
+  /* Copy in at most two pieces, wrapping around the end of the
+     buffer, then publish the new head. */
+  barrier ();
+  first = ring_size (ring) - ofs;
+  if (first > cnt)
+    first = cnt;
+  memcpy (ring->buf + ofs, buf, first);
+  memcpy (ring->buf, (const uint8_t *) buf + first, cnt - first);
+  barrier ();
+  ring->head = head + cnt;
+  return cnt;
+}
+
+/* Removes up to CNT bytes from RING into BUF, as many as are
+   available, and returns the number removed.  Only the consumer
+   may call this function. */
+size_t ring_get (struct ring *ring, void *buf, size_t cnt)
+{
+  size_t tail = ring->tail;
+  size_t avail = ring->head - tail;
+  size_t ofs = tail & ring->mask;
+  size_t first;
+
+  if (cnt > avail)
+    cnt = avail;
+  if (cnt == 0)
+    return 0;
+
+  /* Copy out at most two pieces, then publish the new tail, which
+     hands the space back to the producer. */
+  barrier ();
+  first = ring_size (ring) - ofs;
+  if (first > cnt)
+    first = cnt;
+  memcpy (buf, ring->buf + ofs, first);
+  memcpy ((uint8_t *) buf + first, ring->buf, cnt - first);
+  barrier ();
+  ring->tail = tail + cnt;
+  return cnt;
+}
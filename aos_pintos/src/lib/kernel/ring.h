@@ -0,0 +1,42 @@
+#ifndef __LIB_KERNEL_RING_H
+#define __LIB_KERNEL_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Single-producer, single-consumer ring buffer of bytes.
+
+   One thread of control (a kernel thread or an interrupt
+   handler) may add bytes to a ring while another removes them,
+   without any locking and without turning off interrupts.  This
+   works because only the producer ever writes HEAD and only the
+   consumer ever writes TAIL, and each side publishes its update
+   only after the bytes it covers have been copied.  If more than
+   one thread of control may produce (or consume), the caller
+   must serialize them itself.
+
+   HEAD and TAIL are free-running byte counts, reduced modulo the
+   buffer size only when indexing, so a full ring and an empty
+   ring are told apart without wasting a slot.  The buffer size
+   must be a power of 2. */
+struct ring
+{
+  uint8_t *buf;          /* Storage, MASK + 1 bytes. */
+  size_t mask;           /* Buffer size minus 1. */
+  volatile size_t head;  /* Bytes ever added; written by producer. */
+  volatile size_t tail;  /* Bytes ever removed; written by consumer. */
+};
+
+void ring_init (struct ring *, void *buf, size_t size);
+
+size_t ring_size (const struct ring *);
+size_t ring_count (const struct ring *);
+size_t ring_space (const struct ring *);
+bool ring_empty (const struct ring *);
+bool ring_full (const struct ring *);
+
+size_t ring_put (struct ring *, const void *, size_t cnt);
+size_t ring_get (struct ring *, void *, size_t cnt);
+
+#endif /* lib/kernel/ring.h */
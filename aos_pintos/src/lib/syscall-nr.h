@@ -30,7 +30,15 @@ enum
   SYS_READDIR, /* Reads a directory entry. */
   SYS_ISDIR,   /* Tests if a fd represents a directory. */
   SYS_INUMBER, /* Returns the inode number for a fd. */
-  SYS_STAT  /* Returns information about a file */
+  SYS_STAT,    /* Returns information about a file */
+
+  /* Extensions. */
+  SYS_FORK,   /* Duplicate this process. */
+  SYS_READV,  /* Read from a file into several buffers. */
+  SYS_WRITEV, /* Write to a file from several buffers. */
+  SYS_PREAD,  /* Read from a file at a given position. */
+  SYS_PWRITE, /* Write to a file at a given position. */
+  SYS_PIPE    /* Create a pipe. */
 };
 
 #endif /* lib/syscall-nr.h */
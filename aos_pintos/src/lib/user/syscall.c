@@ -52,6 +52,21 @@
     retval;                                                                    \
   })
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                               \
+  ({                                                                           \
+    int retval;                                                                \
+    asm volatile ("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; "              \
+                  "pushl %[arg0]; pushl %[number]; int $0x30; "                \
+                  "addl $20, %%esp"                                            \
+                  : "=a"(retval)                                               \
+                  : [number] "i"(NUMBER), [arg0] "r"(ARG0), [arg1] "r"(ARG1),  \
+                    [arg2] "r"(ARG2), [arg3] "r"(ARG3)                         \
+                  : "memory");                                                 \
+    retval;                                                                    \
+  })
+
 void halt (void)
 {
   syscall0 (SYS_HALT);
@@ -100,6 +115,34 @@ int symlink (char *target, char *linkpath)
   return syscall2 (SYS_SYMLINK, target, linkpath);
 }
 
+int readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int pipe (int fds[2]) { return syscall1 (SYS_PIPE, fds); }
+
+mapid_t mmap (int fd, void *addr) { return syscall2 (SYS_MMAP, fd, addr); }
+
+void munmap (mapid_t mapid) { syscall1 (SYS_MUNMAP, mapid); }
+
+pid_t fork (void) { return syscall0 (SYS_FORK); }
+
 bool chdir (const char *dir) { return syscall1 (SYS_CHDIR, dir); }
 
 bool mkdir (const char *dir) { return syscall1 (SYS_MKDIR, dir); }
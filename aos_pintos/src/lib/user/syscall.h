@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <uio.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -15,6 +16,11 @@ typedef int mapid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* Longest command line that exec() accepts, in bytes, counting
+   the null terminator.  exec() returns PID_ERROR for a longer
+   one. */
+#define EXEC_CMD_MAX 256
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0 /* Successful execution. */
 #define EXIT_FAILURE 1 /* Unsuccessful execution. */
@@ -34,6 +40,16 @@ void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
 int symlink (char *target, char *linkpath);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int pipe (int fds[2]);
+
+/* Project 3 and optionally project 4. */
+mapid_t mmap (int fd, void *addr);
+void munmap (mapid_t);
+pid_t fork (void);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -4,6 +4,7 @@
 #include <debug.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <syscall.h>
 
 extern const char *test_name;
@@ -37,6 +38,15 @@ void fail (const char *, ...) PRINTF_FORMAT (1, 2) NO_RETURN;
 
 void shuffle (void *, size_t cnt, size_t size);
 
+/* Returns the processor's time-stamp counter, which benchmarks
+   use to report their cost in CPU cycles. */
+static inline uint64_t rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
 void exec_children (const char *child_name, pid_t pids[], size_t child_cnt);
 void wait_children (pid_t pids[], size_t child_cnt);
 
@@ -0,0 +1,95 @@
+/* Measures how fast bytes move through an interrupt queue from
+   an interrupt handler to a kernel thread.
+
+   A producer thread repeatedly invokes a software interrupt
+   whose handler adds a burst of bytes to the queue, without ever
+   waiting.  The main thread removes the bytes in bulk, checks
+   that they arrive in order, and reports how long the transfer
+   took.  When the queue is full the producer yields to let the
+   consumer catch up. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/intq.h"
+#include "devices/timer.h"
+
+/* Number of bytes to transfer. */
+#define TRANSFER_SIZE (1024 * 1024)
+
+/* Bytes added per interrupt. */
+#define BURST_SIZE 16
+
+/* Vector for the producer's software interrupt. */
+#define RING_VEC 0x31
+
+static struct intq queue;
+static size_t produced;
+static struct semaphore done;
+
+static intr_handler_func ring_interrupt;
+static thread_func producer_thread;
+
+void test_ring_throughput (void)
+{
+  uint8_t buf[256];
+  size_t consumed;
+  int64_t start;
+
+  intq_init (&queue);
+  sema_init (&done, 0);
+  intr_register_int (RING_VEC, 0, INTR_OFF, ring_interrupt, "ring");
+
+  start = timer_ticks ();
+  thread_create ("producer", PRI_DEFAULT, producer_thread, NULL);
+
+  consumed = 0;
+  while (consumed < TRANSFER_SIZE)
+    {
+      size_t cnt, i;
+
+      buf[0] = intq_getc (&queue);
+      cnt = 1 + intq_get (&queue, buf + 1, sizeof buf - 1);
+      for (i = 0; i < cnt; i++, consumed++)
+        if (buf[i] != (uint8_t) consumed)
+          fail ("byte %zu is %d, expected %d", consumed, buf[i],
+                (uint8_t) consumed);
+    }
+  sema_down (&done);
+
+  msg ("received %d bytes in order", TRANSFER_SIZE);
+  msg ("throughput: %d bytes in %lld ticks", TRANSFER_SIZE,
+       timer_elapsed (start));
+}
+
+/* Raises software interrupts until all the bytes are queued. */
+static void producer_thread (void *aux UNUSED)
+{
+  while (produced < TRANSFER_SIZE)
+    {
+      size_t before = produced;
+
+      asm volatile ("int %0" : : "i"(RING_VEC) : "memory");
+      if (produced == before)
+        thread_yield ();
+    }
+  sema_up (&done);
+}
+
+/* Adds the next burst of bytes to the queue, as much of it as
+   fits. */
+static void ring_interrupt (struct intr_frame *f UNUSED)
+{
+  uint8_t burst[BURST_SIZE];
+  size_t cnt, i;
+
+  cnt = TRANSFER_SIZE - produced;
+  if (cnt > BURST_SIZE)
+    cnt = BURST_SIZE;
+  for (i = 0; i < cnt; i++)
+    burst[i] = produced + i;
+  produced += intq_put (&queue, burst, cnt);
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# The transfer time varies from run to run, so only its form is
+# checked.
+s/^(\(ring-throughput\) throughput: \d+ bytes in )\d+( ticks)$/$1T$2/
+  foreach @output;
+my (@expected) = ("(ring-throughput) begin",
+		  "(ring-throughput) received 1048576 bytes in order",
+		  "(ring-throughput) throughput: 1048576 bytes in T ticks",
+		  "(ring-throughput) end");
+fail "Test output failed to match expected output:\n"
+  . join ('', map ("  $_\n", @expected))
+  . "Actual output:\n"
+  . join ('', map ("  $_\n", @output))
+  if join ("\n", @output) ne join ("\n", @expected);
+pass;
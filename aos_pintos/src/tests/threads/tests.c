@@ -33,6 +33,7 @@ static const struct test tests[] = {
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"ring-throughput", test_ring_throughput},
 };
 
 static const char *test_name;
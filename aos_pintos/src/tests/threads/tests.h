@@ -28,6 +28,7 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_ring_throughput;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,73 @@
+/* Child process run by pipe-bench and pipe-close tests.
+
+   Invoked as "child-pipe MODE KEEP CLOSE", where KEEP and CLOSE
+   are the numbers of pipe descriptors inherited from the parent.
+   First closes CLOSE, the end that it does not use.  Then, if
+   MODE is "w", writes PIPE_BYTES bytes of a known pattern to
+   KEEP; if MODE is "r", reads from KEEP until end of file and
+   checks that exactly that pattern arrives; and if MODE is "c",
+   reads from KEEP just once and exits, closing its read end with
+   the writer still writing. */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/userprog/pipe-bench.h"
+
+static char buf[PIPE_CHUNK];
+
+/* Returns the byte at offset OFS in the pattern. */
+static char pattern (size_t ofs) { return ofs % 251; }
+
+int main (int argc, char *argv[])
+{
+  size_t ofs = 0;
+  int fd;
+
+  test_name = "child-pipe";
+
+  if (argc != 4 || !isdigit (*argv[2]) || !isdigit (*argv[3]))
+    fail ("bad command-line arguments");
+  fd = atoi (argv[2]);
+  close (atoi (argv[3]));
+
+  if (!strcmp (argv[1], "c"))
+    {
+      if (read (fd, buf, PIPE_CHUNK) <= 0)
+        fail ("read failed");
+      return 0;
+    }
+  else if (!strcmp (argv[1], "w"))
+    while (ofs < PIPE_BYTES)
+      {
+        size_t i;
+
+        for (i = 0; i < PIPE_CHUNK; i++)
+          buf[i] = pattern (ofs + i);
+        if (write (fd, buf, PIPE_CHUNK) != PIPE_CHUNK)
+          fail ("write at offset %zu failed", ofs);
+        ofs += PIPE_CHUNK;
+      }
+  else
+    for (;;)
+      {
+        int n = read (fd, buf, PIPE_CHUNK);
+        int i;
+
+        if (n < 0)
+          fail ("read at offset %zu failed", ofs);
+        if (n == 0)
+          break;
+        for (i = 0; i < n; i++)
+          if (buf[i] != pattern (ofs + i))
+            fail ("bad data at offset %zu", ofs + i);
+        ofs += n;
+      }
+
+  if (ofs != PIPE_BYTES)
+    fail ("transferred %zu bytes, expected %d", ofs, PIPE_BYTES);
+  return 0;
+}
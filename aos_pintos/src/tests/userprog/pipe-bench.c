@@ -0,0 +1,49 @@
+/* Measures pipe throughput between two processes: creates a
+   pipe, executes one copy of child-pipe that writes PIPE_BYTES
+   bytes into it and another that reads them out and checks
+   them, and reports the cost per kilobyte in CPU cycles, as
+   counted by the time-stamp counter, from the first exec() to
+   the second wait().  The cost varies from machine to machine,
+   so the check only verifies that the data arrives intact. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/userprog/pipe-bench.h"
+
+void test_main (void)
+{
+  char cmd_line[64];
+  uint64_t start, cycles;
+  pid_t writer, reader;
+  int fds[2];
+
+  CHECK (pipe (fds) == 0, "pipe");
+
+  start = rdtsc ();
+  snprintf (cmd_line, sizeof cmd_line, "child-pipe w %d %d", fds[1],
+            fds[0]);
+  writer = exec (cmd_line);
+  if (writer == PID_ERROR)
+    fail ("exec() of writer failed");
+  snprintf (cmd_line, sizeof cmd_line, "child-pipe r %d %d", fds[0],
+            fds[1]);
+  reader = exec (cmd_line);
+  if (reader == PID_ERROR)
+    fail ("exec() of reader failed");
+
+  /* The reader sees end of file only once every write end is
+     closed, ours included. */
+  close (fds[0]);
+  close (fds[1]);
+
+  if (wait (writer) != 0)
+    fail ("wait() for writer returned wrong status");
+  if (wait (reader) != 0)
+    fail ("wait() for reader returned wrong status");
+  cycles = rdtsc () - start;
+  msg ("%d bytes, %llu cycles per KB", PIPE_BYTES,
+       cycles / (PIPE_BYTES / 1024));
+}
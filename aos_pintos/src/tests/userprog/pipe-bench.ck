@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# Mask the cycle count, which depends on the host.  The writer
+# always exits first, because the reader can't see end of file
+# until the writer has exited and closed its end.
+s/^(\(pipe-bench\) 262144 bytes, )\d+( cycles per KB)$/$1N$2/
+  foreach @output;
+my (@expected) = ("(pipe-bench) begin",
+		  "(pipe-bench) pipe",
+		  "child-pipe: exit(0)",
+		  "child-pipe: exit(0)",
+		  "(pipe-bench) 262144 bytes, N cycles per KB",
+		  "(pipe-bench) end",
+		  "pipe-bench: exit(0)");
+fail "Test output failed to match expected output:\n"
+  . join ('', map ("  $_\n", @expected))
+  . "Actual output:\n"
+  . join ('', map ("  $_\n", @output))
+  if join ("\n", @output) ne join ("\n", @expected);
+pass;
@@ -0,0 +1,9 @@
+#ifndef TESTS_USERPROG_PIPE_BENCH_H
+#define TESTS_USERPROG_PIPE_BENCH_H
+
+/* Bytes sent through the pipe by pipe-bench, and the size of
+   each write() and read() that moves them. */
+#define PIPE_BYTES (256 * 1024)
+#define PIPE_CHUNK 4096
+
+#endif /* tests/userprog/pipe-bench.h */
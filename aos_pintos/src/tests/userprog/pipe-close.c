@@ -0,0 +1,46 @@
+/* Checks what happens when one side of a pipe is closed.  A
+   reader gets the data still in the pipe after the last write end
+   is closed, then end of file.  A write with every read end
+   closed writes nothing, and a write that is blocked when the
+   last reader exits stops short. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* More than the pipe can hold, so that the write blocks. */
+static char big[4 * 4096];
+
+void test_main (void)
+{
+  char cmd_line[64];
+  char buf[16];
+  pid_t child;
+  int fds[2];
+  int n;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (write (fds[1], "hello", 5) == 5, "write \"hello\"");
+  close (fds[1]);
+  CHECK (read (fds[0], buf, sizeof buf) == 5 && !memcmp (buf, "hello", 5),
+         "read \"hello\" after writer closed");
+  CHECK (read (fds[0], buf, sizeof buf) == 0, "read at end of file");
+  close (fds[0]);
+
+  CHECK (pipe (fds) == 0, "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], "hello", 5) == 0, "write with no reader");
+  close (fds[1]);
+
+  CHECK (pipe (fds) == 0, "pipe");
+  snprintf (cmd_line, sizeof cmd_line, "child-pipe c %d %d", fds[0],
+            fds[1]);
+  CHECK ((child = exec (cmd_line)) != PID_ERROR, "exec child-pipe");
+  close (fds[0]);
+  n = write (fds[1], big, sizeof big);
+  CHECK (n > 0 && n < (int) sizeof big, "short write after reader exited");
+  close (fds[1]);
+  CHECK (wait (child) == 0, "wait for child-pipe");
+}
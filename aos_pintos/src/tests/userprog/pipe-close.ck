@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-close) begin
+(pipe-close) pipe
+(pipe-close) write "hello"
+(pipe-close) read "hello" after writer closed
+(pipe-close) read at end of file
+(pipe-close) pipe
+(pipe-close) write with no reader
+(pipe-close) pipe
+(pipe-close) exec child-pipe
+child-pipe: exit(0)
+(pipe-close) short write after reader exited
+(pipe-close) wait for child-pipe
+(pipe-close) end
+pipe-close: exit(0)
+EOF
+pass;
@@ -0,0 +1,63 @@
+/* Reads and writes files at explicit offsets with pread() and
+   pwrite(): a few bytes in the middle of a sector of
+   "sample.txt", then whole sectors of a larger file, which go to
+   the disk in a single transfer, and a run that starts and ends
+   partway through a sector.  Checks that the data lands where it
+   should, that the file position never moves, and that the
+   console file descriptors can't be used this way. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Size of the larger file, four sectors. */
+#define BIG_SIZE (4 * 512)
+
+static char data[BIG_SIZE];
+static char buf[BIG_SIZE];
+
+void test_main (void)
+{
+  int handle;
+  size_t i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  seek (handle, 10);
+  CHECK (pread (handle, buf, 20, 37) == 20, "pread 20 bytes at offset 37");
+  compare_bytes (buf, sample + 37, 20, 37, "sample.txt");
+  CHECK (pread (handle, buf, sizeof buf, 200) == sizeof sample - 1 - 200,
+         "pread past end of file");
+  compare_bytes (buf, sample + 200, sizeof sample - 1 - 200, 200,
+                 "sample.txt");
+  CHECK (pwrite (handle, "FACT", 4, 20) == 4, "pwrite 4 bytes at offset 20");
+  CHECK (tell (handle) == 10, "tell \"sample.txt\"");
+  memcpy (sample + 20, "FACT", 4);
+  seek (handle, 0);
+  check_file_handle (handle, "sample.txt", sample, sizeof sample - 1);
+  close (handle);
+
+  CHECK (create ("big.dat", BIG_SIZE), "create \"big.dat\"");
+  CHECK ((handle = open ("big.dat")) > 1, "open \"big.dat\"");
+  for (i = 0; i < BIG_SIZE; i++)
+    data[i] = i % 251;
+  CHECK (pwrite (handle, data, BIG_SIZE, 0) == BIG_SIZE,
+         "pwrite 4 whole sectors");
+  CHECK (pread (handle, buf, 2 * 512, 512) == 2 * 512,
+         "pread 2 whole sectors at offset 512");
+  compare_bytes (buf, data + 512, 2 * 512, 512, "big.dat");
+  memset (data + 300, 'x', 1000);
+  CHECK (pwrite (handle, data + 300, 1000, 300) == 1000,
+         "pwrite 1000 bytes at offset 300");
+  CHECK (pread (handle, buf, BIG_SIZE, 0) == BIG_SIZE, "pread whole file");
+  compare_bytes (buf, data, BIG_SIZE, 0, "big.dat");
+  CHECK (tell (handle) == 0, "tell \"big.dat\"");
+  close (handle);
+
+  CHECK (pread (STDIN_FILENO, buf, 1, 0) == -1, "pread stdin");
+  CHECK (pwrite (STDIN_FILENO, buf, 1, 0) == -1, "pwrite stdin");
+  CHECK (pread (STDOUT_FILENO, buf, 1, 0) == -1, "pread stdout");
+  CHECK (pwrite (STDOUT_FILENO, buf, 1, 0) == -1, "pwrite stdout");
+}
@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) open "sample.txt"
+(pread-pwrite) pread 20 bytes at offset 37
+(pread-pwrite) pread past end of file
+(pread-pwrite) pwrite 4 bytes at offset 20
+(pread-pwrite) tell "sample.txt"
+(pread-pwrite) verified contents of "sample.txt"
+(pread-pwrite) create "big.dat"
+(pread-pwrite) open "big.dat"
+(pread-pwrite) pwrite 4 whole sectors
+(pread-pwrite) pread 2 whole sectors at offset 512
+(pread-pwrite) pwrite 1000 bytes at offset 300
+(pread-pwrite) pread whole file
+(pread-pwrite) tell "big.dat"
+(pread-pwrite) pread stdin
+(pread-pwrite) pwrite stdin
+(pread-pwrite) pread stdout
+(pread-pwrite) pwrite stdout
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Measures the round-trip latency of system calls, in CPU cycles
+   as counted by the time-stamp counter: tell(), which takes one
+   argument, and a 0-byte write(), which takes three.  The
+   latency varies from machine to machine, so the check only
+   verifies that the calls succeed. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of times to make each system call. */
+#define CALL_CNT 10000
+
+void test_main (void)
+{
+  uint64_t start, cycles;
+  int handle, i;
+  char buf;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  start = rdtsc ();
+  for (i = 0; i < CALL_CNT; i++)
+    if (tell (handle) != 0)
+      fail ("tell() returned nonzero");
+  cycles = rdtsc () - start;
+  msg ("tell: %d calls, %llu cycles per call", CALL_CNT,
+       cycles / CALL_CNT);
+
+  start = rdtsc ();
+  for (i = 0; i < CALL_CNT; i++)
+    if (write (handle, &buf, 0) != 0)
+      fail ("write() returned nonzero");
+  cycles = rdtsc () - start;
+  msg ("write: %d calls, %llu cycles per call", CALL_CNT,
+       cycles / CALL_CNT);
+}
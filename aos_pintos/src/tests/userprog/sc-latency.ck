@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# Each latency line must name the call and the call count; the
+# cycles per call are replaced by N.
+s/^(\(sc-latency\) \w+: 10000 calls, )\d+( cycles per call)$/$1N$2/
+  foreach @output;
+my (@expected) = ("(sc-latency) begin",
+		  "(sc-latency) open \"sample.txt\"",
+		  "(sc-latency) tell: 10000 calls, N cycles per call",
+		  "(sc-latency) write: 10000 calls, N cycles per call",
+		  "(sc-latency) end",
+		  "sc-latency: exit(0)");
+fail "Test output failed to match expected output:\n"
+  . join ('', map ("  $_\n", @expected))
+  . "Actual output:\n"
+  . join ('', map ("  $_\n", @output))
+  if join ("\n", @output) ne join ("\n", @expected);
+pass;
@@ -0,0 +1,35 @@
+/* Measures how long it takes to start a process: executes
+   SPAWN_CNT copies of child-simple one after another, waiting
+   for each, and reports the average cost of an exec() and
+   wait() pair in CPU cycles, as counted by the time-stamp
+   counter.  The kernel's breakdown of the time by phase of
+   exec, and the number of processes started per second, are
+   printed with its statistics at shutdown.  The cost varies from
+   machine to machine, so the check only verifies that every
+   child runs. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of processes to start. */
+#define SPAWN_CNT 50
+
+void test_main (void)
+{
+  uint64_t start, cycles;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < SPAWN_CNT; i++)
+    {
+      pid_t pid = exec ("child-simple");
+      if (pid == PID_ERROR)
+        fail ("exec() of child %d failed", i);
+      if (wait (pid) != 81)
+        fail ("wait() for child %d returned wrong status", i);
+    }
+  cycles = rdtsc () - start;
+  msg ("%d spawns, %llu cycles per spawn", SPAWN_CNT, cycles / SPAWN_CNT);
+}
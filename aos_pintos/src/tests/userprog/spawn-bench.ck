@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# Every child must run and exit in order; the cycles per spawn
+# are not compared.
+s/^(\(spawn-bench\) 50 spawns, )\d+( cycles per spawn)$/$1N$2/
+  foreach @output;
+my (@expected) = ("(spawn-bench) begin",
+		  ("(child-simple) run", "child-simple: exit(81)") x 50,
+		  "(spawn-bench) 50 spawns, N cycles per spawn",
+		  "(spawn-bench) end",
+		  "spawn-bench: exit(0)");
+fail "Test output failed to match expected output:\n"
+  . join ('', map ("  $_\n", @expected))
+  . "Actual output:\n"
+  . join ('', map ("  $_\n", @output))
+  if join ("\n", @output) ne join ("\n", @expected);
+pass;
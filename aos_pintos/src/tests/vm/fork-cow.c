@@ -0,0 +1,84 @@
+/* Forks a child and checks that the two processes start out
+   with the same memory and descriptors, and that after the fork
+   a write to a stack, data, or BSS variable by either one is not
+   seen by the other.  The child also reads from a file opened
+   before the fork, at the parent's position, and writes to a
+   pipe that the parent reads.  The parent keeps quiet until it
+   has reaped the child, so that the output is in a fixed
+   order. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Exit code of the child. */
+#define CHILD_EXIT 42
+
+static volatile int data_var = 1;
+static volatile int bss_var;
+
+/* Runs in the child.  Waits on SYNC_FD until the parent has
+   written its own copies of the variables, checks that the
+   child's copies still hold their values from before the fork,
+   overwrites them, and reports back on PIPE_FD. */
+static void child (volatile int *stack_var, int handle, int sync_fd,
+                   int pipe_fd)
+{
+  char buf[20];
+  char c;
+
+  if (read (sync_fd, &c, 1) != 1)
+    fail ("child: read from pipe");
+  if (*stack_var != 3 || data_var != 1 || bss_var != 2)
+    fail ("child sees parent's writes after fork");
+
+  if (tell (handle) != 10)
+    fail ("child: inherited file position is %d", tell (handle));
+  if (read (handle, buf, sizeof buf) != sizeof buf)
+    fail ("child: read from inherited file");
+  compare_bytes (buf, sample + 10, sizeof buf, 10, "sample.txt");
+
+  *stack_var = data_var = bss_var = 7;
+  if (write (pipe_fd, "child", 5) != 5)
+    fail ("child: write to inherited pipe");
+  exit (CHILD_EXIT);
+}
+
+void test_main (void)
+{
+  volatile int stack_var = 3;
+  int to_child[2], from_child[2];
+  int handle;
+  pid_t pid;
+  char buf[5];
+  bool mem_ok, pipe_ok;
+  int status;
+
+  bss_var = 2;
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  seek (handle, 10);
+  CHECK (pipe (to_child) == 0, "pipe to child");
+  CHECK (pipe (from_child) == 0, "pipe from child");
+
+  CHECK ((pid = fork ()) != PID_ERROR, "fork");
+  if (pid == 0)
+    child (&stack_var, handle, to_child[0], from_child[1]);
+
+  stack_var = data_var = bss_var = 5;
+  write (to_child[1], "", 1);
+  pipe_ok = (read (from_child[0], buf, sizeof buf) == sizeof buf &&
+             !memcmp (buf, "child", sizeof buf));
+  mem_ok = stack_var == 5 && data_var == 5 && bss_var == 5;
+  status = wait (pid);
+
+  CHECK (pid > 0, "fork returned child's pid");
+  CHECK (status == CHILD_EXIT, "wait for child");
+  CHECK (wait (pid) == -1, "wait for child again");
+  CHECK (mem_ok, "parent's memory unchanged by child");
+  CHECK (pipe_ok, "read \"child\" from inherited pipe");
+  CHECK (tell (handle) == 10, "tell \"sample.txt\"");
+  seek (handle, 0);
+  check_file_handle (handle, "sample.txt", sample, sizeof sample - 1);
+}
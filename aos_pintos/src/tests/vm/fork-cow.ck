@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-cow) begin
+(fork-cow) open "sample.txt"
+(fork-cow) pipe to child
+(fork-cow) pipe from child
+(fork-cow) fork
+fork-cow: exit(42)
+(fork-cow) fork returned child's pid
+(fork-cow) wait for child
+(fork-cow) wait for child again
+(fork-cow) parent's memory unchanged by child
+(fork-cow) read "child" from inherited pipe
+(fork-cow) tell "sample.txt"
+(fork-cow) verified contents of "sample.txt"
+(fork-cow) end
+fork-cow: exit(0)
+EOF
+pass;
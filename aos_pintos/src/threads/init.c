@@ -34,9 +34,16 @@
 #ifdef FILESYS
 #include "devices/block.h"
 #include "devices/ide.h"
+#include "devices/ramdisk.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/stats.h"
+#include "vm/swap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -52,6 +59,11 @@ static const char *scratch_bdev_name;
 #ifdef VM
 static const char *swap_bdev_name;
 #endif
+
+/* -ramdisk, -ramdisk-copy: Size of RAM disk rd0 in kB, and
+   whether to fill it from the file system partition. */
+static size_t ramdisk_kb;
+static bool ramdisk_copy;
 #endif /* FILESYS */
 
 /* -ul: Maximum number of pages to put into palloc's user pool. */
@@ -66,6 +78,7 @@ static void run_actions (char **argv);
 static void usage (void);
 
 #ifdef FILESYS
+static void create_ramdisk (void);
 static void locate_block_devices (void);
 static void locate_block_device (enum block_type, const char *name);
 #endif
@@ -120,10 +133,17 @@ int main (void)
 #ifdef FILESYS
   /* Initialize file system. */
   ide_init ();
+  create_ramdisk ();
   locate_block_devices ();
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize virtual memory. */
+  frame_init ();
+  swap_init ();
+#endif
+
   printf ("Boot complete.\n");
 
   /* Run actions specified on kernel command line. */
@@ -240,6 +260,10 @@ static char **parse_options (char **argv)
         filesys_bdev_name = value;
       else if (!strcmp (name, "-scratch"))
         scratch_bdev_name = value;
+      else if (!strcmp (name, "-ramdisk"))
+        ramdisk_kb = atoi (value);
+      else if (!strcmp (name, "-ramdisk-copy"))
+        ramdisk_copy = true;
 #ifdef VM
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
@@ -252,6 +276,12 @@ static char **parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-sl"))
+        stack_max_pages = atoi (value);
+      else if (!strcmp (name, "-vmstats"))
+        vm_stats_enabled = true;
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -361,6 +391,9 @@ static void usage (void)
           "  -f                 Format file system device during startup.\n"
           "  -filesys=BDEV      Use BDEV for file system instead of default.\n"
           "  -scratch=BDEV      Use BDEV for scratch instead of default.\n"
+          "  -ramdisk=KB        Create a KB-kilobyte RAM disk named rd0.\n"
+          "  -ramdisk-copy      Fill rd0 from the file system partition.\n"
+          "                     Use with -filesys=rd0 to run from RAM.\n"
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
 #endif
@@ -369,12 +402,38 @@ static void usage (void)
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -sl=COUNT          Limit user stacks to COUNT pages.\n"
+          "  -vmstats           Print VM statistics as processes exit.\n"
 #endif
   );
   shutdown_power_off ();
 }
 
 #ifdef FILESYS
+/* Creates RAM disk rd0 if -ramdisk or -ramdisk-copy was given.
+   With -ramdisk-copy, the RAM disk is filled from the first file
+   system partition in probe order, so that -filesys=rd0 runs the
+   file system out of memory without disturbing the disk. */
+static void create_ramdisk (void)
+{
+  struct block *source = NULL;
+
+  if (ramdisk_copy)
+    {
+      for (source = block_first (); source != NULL;
+           source = block_next (source))
+        if (block_type (source) == BLOCK_FILESYS)
+          break;
+      if (source == NULL)
+        PANIC ("-ramdisk-copy: no file system partition to copy");
+    }
+
+  if (ramdisk_kb > 0 || source != NULL)
+    ramdisk_init (ramdisk_kb * 1024 / BLOCK_SECTOR_SIZE, source);
+}
+
 /* Figure out what block devices to cast in the various Pintos roles. */
 static void locate_block_devices (void)
 {
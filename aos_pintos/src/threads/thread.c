@@ -268,6 +268,7 @@ void thread_exit (void)
 #ifdef USERPROG
   process_exit ();
 #endif
+  console_flush ();
 
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
@@ -428,6 +429,12 @@ static void init_thread (struct thread *t, const char *name, int priority)
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
   t->magic = THREAD_MAGIC;
+#ifdef USERPROG
+  list_init (&t->children);
+#endif
+#ifdef VM
+  list_init (&t->mappings);
+#endif
 
   old_level = intr_disable ();
   list_push_back (&all_list, &t->allelem);
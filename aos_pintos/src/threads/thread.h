@@ -1,9 +1,14 @@
 #ifndef THREADS_THREAD_H
 #define THREADS_THREAD_H
 
+#include <console.h>
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#ifdef VM
+#include <hash.h>
+#include "vm/stats.h"
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -97,9 +102,32 @@ struct thread
 
 #ifdef USERPROG
   /* Owned by userprog/process.c. */
-  uint32_t *pagedir; /* Page directory. */
+  uint32_t *pagedir;      /* Page directory. */
+  struct file *exec_file; /* Executable, kept open while running. */
+  int exit_status;        /* Status reported when the process exits. */
+  struct list children;   /* Status records of children, not waited. */
+  struct wait_status *wait_status; /* This process's status record. */
+
+  /* Owned by userprog/syscall.c. */
+  struct fd *fds;        /* Open files and pipes, by descriptor. */
+  struct bitmap *fd_map; /* Descriptors in use. */
+  size_t fd_cnt;         /* Number of slots in FDS and FD_MAP. */
+#ifdef VM
+  struct list mappings; /* Memory-mapped files. */
+  int next_mapid;       /* Number of the next mapping. */
+#endif
 #endif
 
+#ifdef VM
+  /* Owned by vm/page.c. */
+  struct hash pages; /* Supplemental page table. */
+  struct intr_frame *syscall_frame; /* User context of current syscall. */
+  struct vm_stats vm_stats; /* Paging statistics. */
+#endif
+
+  /* Owned by lib/kernel/console.c. */
+  struct console_line console; /* Buffered console output. */
+
   /* Owned by thread.c. */
   unsigned magic; /* Detects stack overflow. */
 };
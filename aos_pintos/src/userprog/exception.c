@@ -2,8 +2,14 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#include "vm/stats.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -20,9 +26,9 @@ static void page_fault (struct intr_frame *);
    signals.  Instead, we'll make them simply kill the user
    process.
 
-   Page faults are an exception.  Here they are treated the same
-   way as other exceptions, but this will need to change to
-   implement virtual memory.
+   Page faults are an exception.  With virtual memory, a fault on
+   a page that has not been loaded yet brings the page in; other
+   page faults are treated the same way as other exceptions.
 
    Refer to [IA32-v3a] section 5.15 "Exception and Interrupt
    Reference" for a description of each of these exceptions. */
@@ -60,6 +66,9 @@ void exception_init (void)
 void exception_print_stats (void)
 {
   printf ("Exception: %lld page faults\n", page_fault_cnt);
+#ifdef VM
+  page_print_stats ();
+#endif
 }
 
 /* Handler for an exception (probably) caused by a user process. */
@@ -102,9 +111,11 @@ static void kill (struct intr_frame *f)
     }
 }
 
-/* Page fault handler.  This is a skeleton that must be filled in
-   to implement virtual memory.  Some solutions to project 2 may
-   also require modifying this code.
+/* Page fault handler.  With virtual memory, loads pages of user
+   programs on demand and grows their stacks (see vm/page.c);
+   otherwise, and for faults that don't name a loadable page,
+   kills the process, or fails the get_user() call that
+   faulted.
 
    At entry, the address that faulted is in CR2 (Control Register
    2) and information about the fault, formatted as described in
@@ -128,6 +139,10 @@ static void page_fault (struct intr_frame *f)
      [IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
      (#PF)". */
   asm("movl %%cr2, %0" : "=r"(fault_addr));
+#ifdef VM
+  vm_trace_fault (fault_addr, f->eip, (f->error_code & PF_W) != 0,
+                  (f->error_code & PF_U) != 0);
+#endif
 
   /* Turn interrupts back on (they were only off so that we could
      be assured of reading CR2 before it changed). */
@@ -141,9 +156,36 @@ static void page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
-  /* To implement virtual memory, delete the rest of the function
-     body, and replace it with code that brings in the page to
-     which fault_addr refers. */
+#ifdef VM
+  /* A user page that isn't present may simply not have been
+     loaded yet, and a write to a page mapped to the read-only
+     zero page needs a frame of its own.  If so, bring the page
+     in and retry the access.  Otherwise, an access just below
+     the stack pointer grows the stack.  A fault in the kernel
+     inside a system call compares against the user stack pointer
+     saved on entry.  A fault in the kernel outside any system
+     call, while loading or forking a process, has no user stack
+     pointer to compare against, so it never grows the stack. */
+  if ((not_present || write) && is_user_vaddr (fault_addr) &&
+      thread_current ()->pagedir != NULL)
+    {
+      struct intr_frame *sf = thread_current ()->syscall_frame;
+
+      if (page_load (fault_addr, write))
+        return;
+      if (not_present && (user || sf != NULL) &&
+          page_is_stack (fault_addr, user ? f->esp : sf->esp) &&
+          page_grow_stack (fault_addr))
+        return;
+    }
+#endif
+
+  /* A kernel access to a user address from get_user() in
+     userprog/syscall.c expects a failed access to be reported
+     back to it.  Any other is a kernel bug. */
+  if (!user && is_user_vaddr (fault_addr) && syscall_fixup_fault (f))
+    return;
+
   printf ("Page fault at %p: %s error %s page in %s context.\n", fault_addr,
           not_present ? "not present" : "rights violation",
           write ? "writing" : "reading", user ? "user" : "kernel");
@@ -1,13 +1,19 @@
 #include "userprog/pagedir.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 
+/* Statistics. */
+static long long pd_load_cnt;    /* Page directories loaded. */
+static long long pd_skip_cnt;    /* Loads skipped as unneeded. */
+static long long page_flush_cnt; /* Single TLB entries flushed. */
+
 static uint32_t *active_pd (void);
-static void invalidate_pagedir (uint32_t *);
+static void invalidate_page (uint32_t *, const void *);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -146,10 +152,19 @@ void pagedir_clear_page (uint32_t *pd, void *upage)
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
     }
 }
 
+/* Returns true if PD maps virtual page VPAGE present and
+   writable.
+   Returns false if PD contains no PTE for VPAGE. */
+bool pagedir_is_writable (uint32_t *pd, const void *vpage)
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  return pte != NULL && (*pte & (PTE_P | PTE_W)) == (PTE_P | PTE_W);
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
@@ -172,7 +187,7 @@ void pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
       else
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -199,17 +214,32 @@ void pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
       else
         {
           *pte &= ~(uint32_t) PTE_A;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
 
 /* Loads page directory PD into the CPU's page directory base
-   register. */
+   register, unless it is already there.  If PD is null, as it is
+   for a kernel thread, any page directory will do, since every
+   one maps the kernel the same way, so whichever is loaded
+   stays.
+
+   Loading CR3 flushes the whole TLB, so skipping needless loads
+   keeps a process's translations cached across switches to
+   kernel threads and back.  The loaded page directory is read
+   back from CR3 itself, which can't go out of date the way a
+   copy in memory could if a thread switch came between checking
+   and loading.  A process that is about to destroy its page
+   directory must load init_page_dir explicitly first. */
 void pagedir_activate (uint32_t *pd)
 {
-  if (pd == NULL)
-    pd = init_page_dir;
+  if (pd == NULL || pd == active_pd ())
+    {
+      pd_skip_cnt++;
+      return;
+    }
+  pd_load_cnt++;
 
   /* Store the physical address of the page directory into CR3
      aka PDBR (page directory base register).  This activates our
@@ -231,20 +261,30 @@ static uint32_t *active_pd (void)
   return ptov (pd);
 }
 
-/* Seom page table changes can cause the CPU's translation
+/* Prints page directory statistics. */
+void pagedir_print_stats (void)
+{
+  printf ("Paging: %lld page directory loads, %lld skipped, "
+          "%lld single-page TLB flushes\n",
+          pd_load_cnt, pd_skip_cnt, page_flush_cnt);
+}
+
+/* Some page table changes can cause the CPU's translation
    lookaside buffer (TLB) to become out-of-sync with the page
-   table.  When this happens, we have to "invalidate" the TLB by
-   re-activating it.
+   table.  When this happens, we have to "invalidate" the stale
+   entry.
 
-   This function invalidates the TLB if PD is the active page
-   directory.  (If PD is not active then its entries are not in
-   the TLB, so there is no need to invalidate anything.) */
-static void invalidate_pagedir (uint32_t *pd)
+   This function invalidates the TLB entry for user virtual page
+   VPAGE if PD is the active page directory.  (If PD is not
+   active then its entries are not in the TLB, so there is no
+   need to invalidate anything.)  Only that one entry goes, with
+   INVLPG, rather than the whole TLB, as reloading CR3 would do.
+   See [IA32-v3a] 3.12 "Translation Lookaside Buffers (TLBs)". */
+static void invalidate_page (uint32_t *pd, const void *vpage)
 {
   if (active_pd () == pd)
     {
-      /* Re-activating PD clears the TLB.  See [IA32-v3a] 3.12
-         "Translation Lookaside Buffers (TLBs)". */
-      pagedir_activate (pd);
+      page_flush_cnt++;
+      asm volatile("invlpg (%0)" : : "r"(vpage) : "memory");
     }
 }
@@ -0,0 +1,180 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A pipe: a one-page ring buffer in the kernel, with any number
+   of read ends and write ends open on it.
+
+   Readers block while the buffer is empty and writers while it
+   is full.  A read returns whatever is in the buffer, up to the
+   amount asked for, or 0 at end of file, once the buffer is
+   empty and every write end is closed.  A write blocks until all
+   of its data is in the buffer, unless every read end is closed,
+   in which case it stops short.
+
+   Data is copied straight between the ring buffer and the
+   caller's buffer, which may be user memory, as long as the
+   caller has pinned it. */
+struct pipe
+{
+  struct lock lock;           /* Protects the other members. */
+  struct condition not_empty; /* Signaled when data arrives. */
+  struct condition not_full;  /* Signaled when room appears. */
+  uint8_t *buf;               /* Ring buffer, PGSIZE bytes. */
+  size_t head;                /* Offset of first byte to read. */
+  size_t used;                /* Number of bytes in BUF. */
+  int readers;                /* Number of open read ends. */
+  int writers;                /* Number of open write ends. */
+};
+
+/* Creates and returns a new, empty pipe, with one read end and
+   one write end open.  Returns a null pointer if memory is
+   exhausted. */
+struct pipe *pipe_create (void)
+{
+  struct pipe *p = malloc (sizeof *p);
+
+  if (p == NULL)
+    return NULL;
+  p->buf = palloc_get_page (0);
+  if (p->buf == NULL)
+    {
+      free (p);
+      return NULL;
+    }
+
+  lock_init (&p->lock);
+  cond_init (&p->not_empty);
+  cond_init (&p->not_full);
+  p->head = 0;
+  p->used = 0;
+  p->readers = 1;
+  p->writers = 1;
+  return p;
+}
+
+/* Opens another write end of P if WRITER is true, otherwise
+   another read end. */
+void pipe_reopen (struct pipe *p, bool writer)
+{
+  lock_acquire (&p->lock);
+  if (writer)
+    p->writers++;
+  else
+    p->readers++;
+  lock_release (&p->lock);
+}
+
+/* Closes a write end of P if WRITER is true, otherwise a read
+   end, and frees P once every end is closed.  Closing the last
+   write end wakes readers to see end of file, and closing the
+   last read end wakes writers to give up. */
+void pipe_close (struct pipe *p, bool writer)
+{
+  bool unused;
+
+  lock_acquire (&p->lock);
+  if (writer)
+    {
+      ASSERT (p->writers > 0);
+      if (--p->writers == 0)
+        cond_broadcast (&p->not_empty, &p->lock);
+    }
+  else
+    {
+      ASSERT (p->readers > 0);
+      if (--p->readers == 0)
+        cond_broadcast (&p->not_full, &p->lock);
+    }
+  unused = p->readers == 0 && p->writers == 0;
+  lock_release (&p->lock);
+
+  if (unused)
+    {
+      palloc_free_page (p->buf);
+      free (p);
+    }
+}
+
+/* Reads up to SIZE bytes from P into BUFFER, blocking until at
+   least one byte is available or every write end is closed.
+   Returns the number of bytes read, which is 0 only at end of
+   file or if SIZE is 0. */
+size_t pipe_read (struct pipe *p, void *buffer_, size_t size)
+{
+  uint8_t *buffer = buffer_;
+  size_t bytes_read = 0;
+
+  if (size == 0)
+    return 0;
+
+  lock_acquire (&p->lock);
+  while (p->used == 0 && p->writers > 0)
+    cond_wait (&p->not_empty, &p->lock);
+
+  /* The data may wrap around the end of the ring, so copy it in
+     up to two pieces. */
+  while (bytes_read < size && p->used > 0)
+    {
+      size_t chunk = PGSIZE - p->head;
+
+      if (chunk > p->used)
+        chunk = p->used;
+      if (chunk > size - bytes_read)
+        chunk = size - bytes_read;
+      memcpy (buffer + bytes_read, p->buf + p->head, chunk);
+      p->head = (p->head + chunk) % PGSIZE;
+      p->used -= chunk;
+      bytes_read += chunk;
+    }
+
+  /* A page's worth of room may have opened up, enough for every
+     waiting writer to make progress, so wake them all. */
+  if (bytes_read > 0)
+    cond_broadcast (&p->not_full, &p->lock);
+  lock_release (&p->lock);
+
+  return bytes_read;
+}
+
+/* Writes the SIZE bytes in BUFFER to P, blocking whenever P is
+   full.  Returns the number of bytes written, which is less than
+   SIZE only if every read end of P is closed. */
+size_t pipe_write (struct pipe *p, const void *buffer_, size_t size)
+{
+  const uint8_t *buffer = buffer_;
+  size_t bytes_written = 0;
+
+  lock_acquire (&p->lock);
+  while (bytes_written < size && p->readers > 0)
+    {
+      size_t tail = (p->head + p->used) % PGSIZE;
+      size_t chunk = PGSIZE - tail;
+
+      if (p->used == PGSIZE)
+        {
+          cond_wait (&p->not_full, &p->lock);
+          continue;
+        }
+
+      if (chunk > PGSIZE - p->used)
+        chunk = PGSIZE - p->used;
+      if (chunk > size - bytes_written)
+        chunk = size - bytes_written;
+      memcpy (p->buf + tail, buffer + bytes_written, chunk);
+      p->used += chunk;
+      bytes_written += chunk;
+
+      /* Wake every waiting reader: the data may be enough for
+         more than one of them. */
+      cond_broadcast (&p->not_empty, &p->lock);
+    }
+  lock_release (&p->lock);
+
+  return bytes_written;
+}
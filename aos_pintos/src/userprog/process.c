@@ -7,62 +7,205 @@
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "devices/timer.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#include "vm/stats.h"
+#endif
+
+/* The exit status of a child process, shared between the child
+   and its parent so that it outlives whichever of them exits
+   first.  It is freed when both have let go of it: the child by
+   exiting, the parent by waiting for the child or by exiting. */
+struct wait_status
+{
+  struct list_elem elem;  /* Element in parent's `children' list. */
+  tid_t tid;              /* Child's thread id. */
+  int exit_status;        /* Child's exit status, once DEAD is up. */
+  struct semaphore dead;  /* Upped when the child exits. */
+  struct lock ref_lock;   /* Protects REF_CNT. */
+  int ref_cnt;            /* 2 = both alive, 1 = one alive, 0 = free. */
+};
+
+/* Passed from process_execute() to the child it creates. */
+struct exec_info
+{
+  struct thread *parent;           /* Process calling exec(). */
+  const char *cmd_line;            /* Command line, the parent's. */
+  struct wait_status *wait_status; /* Child's status record. */
+  struct semaphore loaded;         /* Upped when the load is done. */
+  bool success;                    /* Whether the load succeeded. */
+  uint64_t start_tsc;              /* Time stamp when exec began. */
+  int64_t start_tick;              /* Timer tick when exec began. */
+};
+
+/* Phases of starting a user program, timed in CPU cycles for
+   process_print_stats().  With virtual memory, segments are only
+   recorded at load time and read in later, as they fault. */
+enum exec_phase
+{
+  EXEC_SPAWN,    /* Creating and first scheduling the thread. */
+  EXEC_PAGEDIR,  /* Creating the page directory. */
+  EXEC_HEADER,   /* Opening the file and getting its headers. */
+  EXEC_SEGMENTS, /* Loading segments. */
+  EXEC_STACK,    /* Setting up the stack and arguments. */
+  EXEC_PHASE_CNT
+};
+
+/* Names of the phases, for printing. */
+static const char *exec_phase_names[EXEC_PHASE_CNT] = {
+    "spawn", "pagedir", "header", "segments", "stack",
+};
+
+/* Statistics. */
+static long long exec_cnt;                   /* Programs started. */
+static uint64_t exec_cycles[EXEC_PHASE_CNT]; /* Cycles in each phase. */
+static uint64_t exec_total_cycles;           /* Cycles to user mode. */
+static int64_t exec_first_tick;              /* When the first began. */
+static int64_t exec_last_tick;               /* When the last finished. */
+static long long image_hit_cnt;              /* Image cache hits. */
+static long long image_miss_cnt;             /* Image cache misses. */
 
 static thread_func start_process NO_RETURN;
-static bool load (const char *cmdline, void (**eip) (void), void **esp);
+static bool load (const char *cmd_line, void (**eip) (void), void **esp,
+                  uint64_t cycles[]);
+static void exec_account (uint64_t start_tsc, int64_t start_tick,
+                          const uint64_t cycles[]);
+
+/* Returns the CPU's time-stamp counter, which counts clock
+   cycles. */
+static inline uint64_t rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+static struct wait_status *wait_status_create (void);
+static void wait_status_release (struct wait_status *);
+
+#ifdef VM
+/* Passed from process_fork() to the child it creates. */
+struct fork_info
+{
+  struct thread *parent;           /* Forking process. */
+  struct intr_frame if_;           /* Parent's user context. */
+  struct wait_status *wait_status; /* Child's status record. */
+  struct semaphore done;           /* Upped when the child is set up. */
+  bool success;                    /* Whether the child was set up. */
+};
+
+static thread_func start_fork NO_RETURN;
+#endif
 
 /* Starts a new thread running a user program loaded from
-   FILENAME.  The new thread may be scheduled (and may even exit)
-   before process_execute() returns.  Returns the new process's
-   thread id, or TID_ERROR if the thread cannot be created. */
+   FILENAME, and waits for it to finish loading.  Returns the new
+   process's thread id, or TID_ERROR if the thread cannot be
+   created or the program cannot be loaded.
+
+   FILE_NAME is actually a whole command line: the program name
+   followed by its arguments, separated by spaces, no longer than
+   EXEC_CMD_MAX bytes counting the null terminator.
+
+   The new process inherits the running process's open pipe ends,
+   under the same descriptor numbers, so that the two can talk
+   through a pipe.  This is a departure from standard Pintos, in
+   which exec() passes on no descriptors at all.  Open files are
+   still not inherited. */
 tid_t process_execute (const char *file_name)
 {
-  char *fn_copy;
+  struct thread *cur = thread_current ();
+  char name[sizeof cur->name];
+  struct exec_info exec;
   tid_t tid;
 
-  /* Make a copy of FILE_NAME.
-     Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
-  if (fn_copy == NULL)
+  exec.start_tsc = rdtsc ();
+  exec.start_tick = timer_ticks ();
+
+  /* We wait for the load to finish, so the child can read the
+     command line straight out of FILE_NAME without a copy, and
+     our file descriptor table too. */
+  exec.parent = cur;
+  exec.cmd_line = file_name;
+  exec.wait_status = wait_status_create ();
+  if (exec.wait_status == NULL)
     return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
+  sema_init (&exec.loaded, 0);
+  exec.success = false;
 
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (file_name, PRI_DEFAULT, start_process, fn_copy);
+  /* Name the thread after the program. */
+  file_name += strspn (file_name, " ");
+  strlcpy (name, file_name, sizeof name);
+  name[strcspn (name, " ")] = '\0';
+
+  /* Create a new thread to execute FILE_NAME, and wait for it to
+     load. */
+  tid = thread_create (name, PRI_DEFAULT, start_process, &exec);
   if (tid == TID_ERROR)
-    palloc_free_page (fn_copy);
+    {
+      free (exec.wait_status);
+      return TID_ERROR;
+    }
+  sema_down (&exec.loaded);
+
+  if (!exec.success)
+    {
+      /* The child is exiting, and nobody will wait for it. */
+      wait_status_release (exec.wait_status);
+      return TID_ERROR;
+    }
+  exec.wait_status->tid = tid;
+  list_push_back (&cur->children, &exec.wait_status->elem);
   return tid;
 }
 
 /* A thread function that loads a user process and starts it
    running. */
-static void start_process (void *file_name_)
+static void start_process (void *exec_)
 {
-  char *file_name = file_name_;
+  struct exec_info *exec = exec_;
+  uint64_t start_tsc = exec->start_tsc;
+  int64_t start_tick = exec->start_tick;
+  struct thread *t = thread_current ();
+  uint64_t cycles[EXEC_PHASE_CNT];
   struct intr_frame if_;
   bool success;
 
+  cycles[EXEC_SPAWN] = rdtsc () - start_tsc;
+
+  /* Until the process calls exit(), it's being killed. */
+  t->exit_status = -1;
+  t->wait_status = exec->wait_status;
+
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load (file_name, &if_.eip, &if_.esp);
+  success = load (exec->cmd_line, &if_.eip, &if_.esp, cycles) &&
+            syscall_exec (exec->parent);
+
+  /* EXEC belongs to the parent, so don't touch it after this. */
+  exec->success = success;
+  sema_up (&exec->loaded);
 
   /* If load failed, quit. */
-  palloc_free_page (file_name);
   if (!success)
     thread_exit ();
+  exec_account (start_tsc, start_tick, cycles);
 
   /* Start the user process by simulating a return from an
      interrupt, implemented by intr_exit (in
@@ -74,6 +217,164 @@ static void start_process (void *file_name_)
   NOT_REACHED ();
 }
 
+#ifdef VM
+/* Creates a copy of the running process, which entered the
+   kernel with user context IF.  The child shares the parent's
+   memory copy-on-write, and starts with copies of the parent's
+   open files, but not its memory-mapped files.  Returns the
+   child's thread id in the parent, or TID_ERROR if the child
+   cannot be created.  In the child, fork() returns 0. */
+tid_t process_fork (const struct intr_frame *if_)
+{
+  struct fork_info info;
+  tid_t tid;
+
+  info.parent = thread_current ();
+  info.if_ = *if_;
+  info.wait_status = wait_status_create ();
+  if (info.wait_status == NULL)
+    return TID_ERROR;
+  sema_init (&info.done, 0);
+  info.success = false;
+
+  /* The child copies our state while we wait. */
+  tid = thread_create (info.parent->name, PRI_DEFAULT, start_fork, &info);
+  if (tid == TID_ERROR)
+    {
+      free (info.wait_status);
+      return TID_ERROR;
+    }
+  sema_down (&info.done);
+
+  if (!info.success)
+    {
+      wait_status_release (info.wait_status);
+      return TID_ERROR;
+    }
+  info.wait_status->tid = tid;
+  list_push_back (&info.parent->children, &info.wait_status->elem);
+  return tid;
+}
+
+/* A thread function that copies the process described by
+   INFO_, a struct fork_info, and starts it running. */
+static void start_fork (void *info_)
+{
+  struct fork_info *info = info_;
+  struct thread *parent = info->parent;
+  struct thread *t = thread_current ();
+  struct intr_frame if_ = info->if_;
+  bool success = false;
+
+  t->exit_status = -1;
+  t->wait_status = info->wait_status;
+  t->pagedir = pagedir_create ();
+  if (t->pagedir != NULL && page_table_init ())
+    {
+      process_activate ();
+
+      lock_acquire (&filesys_lock);
+      t->exec_file = file_reopen (parent->exec_file);
+      if (t->exec_file != NULL)
+        file_deny_write (t->exec_file);
+      lock_release (&filesys_lock);
+
+      success = (t->exec_file != NULL &&
+                 page_table_clone (parent, parent->exec_file,
+                                   t->exec_file) &&
+                 syscall_fork (parent));
+    }
+
+  /* INFO belongs to the parent, so don't touch it after this. */
+  info->success = success;
+  sema_up (&info->done);
+  if (!success)
+    thread_exit ();
+
+  /* Return to user mode just like the parent, but returning 0
+     from fork(). */
+  if_.eax = 0;
+  asm volatile("movl %0, %%esp; jmp intr_exit" : : "g"(&if_) : "memory");
+  NOT_REACHED ();
+}
+#endif
+
+/* Adds to the statistics an exec that began at time stamp
+   START_TSC and timer tick START_TICK, spent CYCLES[] in each
+   phase, and is about to enter user mode. */
+static void exec_account (uint64_t start_tsc, int64_t start_tick,
+                          const uint64_t cycles[])
+{
+  uint64_t total = rdtsc () - start_tsc;
+  enum intr_level old_level;
+  int i;
+
+  old_level = intr_disable ();
+  if (exec_cnt++ == 0)
+    exec_first_tick = start_tick;
+  exec_last_tick = timer_ticks ();
+  for (i = 0; i < EXEC_PHASE_CNT; i++)
+    exec_cycles[i] += cycles[i];
+  exec_total_cycles += total;
+  intr_set_level (old_level);
+}
+
+/* Prints statistics about starting user programs: the average
+   number of cycles from exec to the first user instruction, how
+   they break down by phase, and the rate at which programs were
+   started. */
+void process_print_stats (void)
+{
+  int64_t ticks = exec_last_tick - exec_first_tick;
+  int i;
+
+  if (exec_cnt == 0)
+    return;
+
+  printf ("Exec: %lld programs started, %llu cycles each to user mode\n",
+          exec_cnt, exec_total_cycles / exec_cnt);
+  printf ("Exec: average cycles by phase:");
+  for (i = 0; i < EXEC_PHASE_CNT; i++)
+    printf (" %s %llu", exec_phase_names[i], exec_cycles[i] / exec_cnt);
+  printf ("\n");
+  if (ticks > 0)
+    printf ("Exec: %lld programs in %lld ticks, %lld per second\n",
+            exec_cnt, ticks, exec_cnt * TIMER_FREQ / ticks);
+  printf ("Exec: %lld image cache hits, %lld misses\n", image_hit_cnt,
+          image_miss_cnt);
+}
+
+/* Returns a new status record for a child process, held by
+   both the child and its parent, or a null pointer if memory is
+   exhausted. */
+static struct wait_status *wait_status_create (void)
+{
+  struct wait_status *ws = malloc (sizeof *ws);
+
+  if (ws != NULL)
+    {
+      ws->tid = TID_ERROR;
+      ws->exit_status = -1;
+      sema_init (&ws->dead, 0);
+      lock_init (&ws->ref_lock);
+      ws->ref_cnt = 2;
+    }
+  return ws;
+}
+
+/* Drops a reference to WS, freeing it if that was the last. */
+static void wait_status_release (struct wait_status *ws)
+{
+  int ref_cnt;
+
+  lock_acquire (&ws->ref_lock);
+  ref_cnt = --ws->ref_cnt;
+  lock_release (&ws->ref_lock);
+
+  if (ref_cnt == 0)
+    free (ws);
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -81,9 +382,30 @@ static void start_process (void *file_name_)
    been successfully called for the given TID, returns -1
    immediately, without waiting.
 
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
-int process_wait (tid_t child_tid UNUSED) { return -1; }
+   The wait blocks on the child's status record, which stays
+   valid even if the child has already exited. */
+int process_wait (tid_t child_tid)
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = list_next (e))
+    {
+      struct wait_status *ws = list_entry (e, struct wait_status, elem);
+      if (ws->tid == child_tid)
+        {
+          int status;
+
+          list_remove (e);
+          sema_down (&ws->dead);
+          status = ws->exit_status;
+          wait_status_release (ws);
+          return status;
+        }
+    }
+  return -1;
+}
 
 /* Free the current process's resources. */
 void process_exit (void)
@@ -91,6 +413,36 @@ void process_exit (void)
   struct thread *cur = thread_current ();
   uint32_t *pd;
 
+  /* Kernel threads have no page directory, and no process to
+     report on. */
+  if (cur->pagedir != NULL)
+    {
+      printf ("%s: exit(%d)\n", cur->name, cur->exit_status);
+#ifdef VM
+      if (vm_stats_enabled)
+        vm_stats_print (cur->name, &cur->vm_stats);
+#endif
+    }
+
+  /* Close open files and unmap memory-mapped files. */
+  syscall_process_exit ();
+
+#ifdef VM
+  /* Destroy the supplemental page table, freeing the frames and
+     swap slots that hold the process's pages. */
+  page_table_destroy ();
+#endif
+
+  /* Close the executable, which pages may have been loaded from
+     up to now.  This also allows writes to it again. */
+  if (cur->exec_file != NULL)
+    {
+      lock_acquire (&filesys_lock);
+      file_close (cur->exec_file);
+      lock_release (&filesys_lock);
+      cur->exec_file = NULL;
+    }
+
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -102,11 +454,33 @@ void process_exit (void)
          process page directory.  We must activate the base page
          directory before destroying the process's page
          directory, or our active page directory will be one
-         that's been freed (and cleared). */
+         that's been freed (and cleared).  Activating a null
+         page directory would leave ours loaded, so name the
+         base page directory explicitly. */
       cur->pagedir = NULL;
-      pagedir_activate (NULL);
+      pagedir_activate (init_page_dir);
       pagedir_destroy (pd);
     }
+
+  /* Let go of the records of any children we never waited for.
+     Then report our exit status to our parent, if we have one.
+     This comes last, so that by the time the parent wakes up,
+     our output is printed and our executable is writable
+     again. */
+  while (!list_empty (&cur->children))
+    {
+      struct list_elem *e = list_pop_front (&cur->children);
+      wait_status_release (list_entry (e, struct wait_status, elem));
+    }
+  if (cur->wait_status != NULL)
+    {
+      struct wait_status *ws = cur->wait_status;
+
+      ws->exit_status = cur->exit_status;
+      sema_up (&ws->dead);
+      wait_status_release (ws);
+      cur->wait_status = NULL;
+    }
 }
 
 /* Sets up the CPU for running user code in the current
@@ -187,49 +561,249 @@ struct Elf32_Phdr
 #define PF_W 2 /* Writable. */
 #define PF_R 4 /* Readable. */
 
-static bool setup_stack (void **esp);
+/* A segment of an executable, as load_segment() loads it. */
+struct segment
+{
+  off_t ofs;           /* Offset in file of the first page. */
+  uint8_t *upage;      /* User address of the first page. */
+  uint32_t read_bytes; /* Bytes to read from the file. */
+  uint32_t zero_bytes; /* Bytes to zero following them. */
+  bool writable;       /* Writable by the process? */
+};
+
+/* The headers of an executable, read and checked. */
+struct image
+{
+  struct list_elem elem; /* Element in `image_cache'. */
+  struct file *file;     /* Holds the file open, if cached. */
+  unsigned version;      /* Inode version read, if cached. */
+  uint32_t entry;        /* Entry point. */
+  struct segment *segs;  /* Loadable segments. */
+  size_t seg_cnt;        /* Number of loadable segments. */
+};
+
+/* Most executables kept in the image cache. */
+#define IMAGE_CACHE_SIZE 8
+
+/* The image cache: the headers of recently run executables, most
+   recent first, so that running one again needn't read and check
+   them again.  Holding each executable open also keeps its inode,
+   and with it the inode version that the sharing table in
+   vm/frame.c stamps its text frames with, so that those frames
+   are still valid when the program runs again.  (Without an open
+   file, the inode would be closed between runs and reopened with
+   a new version, making every cached frame look stale.)
+
+   Writing to an executable changes its version, which makes both
+   stale, so there is no need to hook file_allow_write(): writes
+   are only possible after it, and they are what count.  A stale
+   image is dropped the next time it is looked up.  Removing an
+   executable, though, must not leave its blocks allocated until
+   the image happens to be evicted, so sys_remove() calls
+   process_drop_stale_images() to close it right away.
+   Protected by filesys_lock. */
+static struct list image_cache = LIST_INITIALIZER (image_cache);
+static size_t image_cache_cnt;
+
+static struct image *image_lookup (struct file *);
+static struct image *image_read (struct file *, const char *file_name);
+static bool add_segment (struct image *, size_t *seg_cap,
+                         const struct Elf32_Phdr *);
+static bool image_insert (struct image *, struct file *);
+static void image_evict (struct image *);
+static void image_free (struct image *);
+static bool setup_stack (void **esp, const char *cmd_line);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
                           bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
+/* Loads an ELF executable into the current thread.  CMD_LINE
+   holds the program name followed by its arguments, separated by
+   spaces.
    Stores the executable's entry point into *EIP
-   and its initial stack pointer into *ESP.
+   and its initial stack pointer into *ESP, and the cycles spent
+   in each phase of the load into CYCLES[], indexed by enum
+   exec_phase.
    Returns true if successful, false otherwise. */
-bool load (const char *file_name, void (**eip) (void), void **esp)
+bool load (const char *cmd_line, void (**eip) (void), void **esp,
+           uint64_t cycles[])
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
   struct file *file = NULL;
-  off_t file_ofs;
+  struct image *image = NULL;
+  bool cached = false;
+  char file_name[NAME_MAX + 2];
+  uint64_t tsc;
   bool success = false;
-  int i;
+  size_t i;
+
+  /* The program name is the first word of CMD_LINE.  A name one
+     byte longer than any file name can be is kept that long, so
+     that it still fails to open. */
+  cmd_line += strspn (cmd_line, " ");
+  strlcpy (file_name, cmd_line, sizeof file_name);
+  file_name[strcspn (file_name, " ")] = '\0';
+  if (file_name[0] == '\0')
+    return false;
 
   /* Allocate and activate page directory. */
+  tsc = rdtsc ();
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL)
     goto done;
   process_activate ();
+#ifdef VM
+  if (!page_table_init ())
+    goto done;
+#endif
+  cycles[EXEC_PAGEDIR] = rdtsc () - tsc;
+  tsc += cycles[EXEC_PAGEDIR];
 
-  /* Open executable file. */
+  /* Open executable file.  It stays open, in T->exec_file, until
+     the process exits, so that pages can be loaded from it on
+     demand, and writes to it are denied meanwhile. */
+  lock_acquire (&filesys_lock);
   file = filesys_open (file_name);
   if (file == NULL)
     {
       printf ("load: %s: open failed\n", file_name);
       goto done;
     }
+  t->exec_file = file;
+  file_deny_write (file);
+
+  /* Get the executable's headers, from the image cache if the
+     program has run before and hasn't changed since. */
+  image = image_lookup (file);
+  cached = image != NULL;
+  if (image == NULL)
+    {
+      image = image_read (file, file_name);
+      if (image == NULL)
+        goto done;
+      cached = image_insert (image, file);
+    }
+  cycles[EXEC_HEADER] = rdtsc () - tsc;
+  tsc += cycles[EXEC_HEADER];
+
+  /* Load segments. */
+  for (i = 0; i < image->seg_cnt; i++)
+    {
+      const struct segment *seg = &image->segs[i];
+
+      if (!load_segment (file, seg->ofs, seg->upage, seg->read_bytes,
+                         seg->zero_bytes, seg->writable))
+        goto done;
+    }
+
+  /* Start address.  A cached image may be evicted as soon as we
+     release the lock, so get it now. */
+  *eip = (void (*) (void)) image->entry;
+  lock_release (&filesys_lock);
+  cycles[EXEC_SEGMENTS] = rdtsc () - tsc;
+  tsc += cycles[EXEC_SEGMENTS];
+
+  /* Set up stack. */
+  if (!setup_stack (esp, cmd_line))
+    goto done;
+  cycles[EXEC_STACK] = rdtsc () - tsc;
+
+  success = true;
+
+done:
+  /* We arrive here whether the load is successful or not.  The
+     executable is closed by process_exit(). */
+  if (image != NULL && !cached)
+    image_free (image);
+  if (lock_held_by_current_thread (&filesys_lock))
+    lock_release (&filesys_lock);
+  return success;
+}
+
+/* load() helpers. */
+
+/* Drops from the image cache every image whose executable has
+   been removed or written since it was cached, closing the file
+   so that a removed executable's blocks can be freed once no
+   process is running it.  The caller must hold filesys_lock. */
+void process_drop_stale_images (void)
+{
+  struct list_elem *e, *next;
+
+  for (e = list_begin (&image_cache); e != list_end (&image_cache);
+       e = next)
+    {
+      struct image *image = list_entry (e, struct image, elem);
+      struct inode *inode = file_get_inode (image->file);
+
+      next = list_next (e);
+      if (inode_is_removed (inode) ||
+          image->version != inode_get_version (inode))
+        image_evict (image);
+    }
+}
+
+/* Returns the cached image of FILE, an executable, or a null
+   pointer if it is not cached or has been written since it was.
+   The caller must hold filesys_lock. */
+static struct image *image_lookup (struct file *file)
+{
+  struct inode *inode = file_get_inode (file);
+  struct list_elem *e;
+
+  for (e = list_begin (&image_cache); e != list_end (&image_cache);
+       e = list_next (e))
+    {
+      struct image *image = list_entry (e, struct image, elem);
+      if (file_get_inode (image->file) == inode)
+        {
+          if (image->version != inode_get_version (inode))
+            {
+              image_evict (image);
+              break;
+            }
+          list_remove (e);
+          list_push_front (&image_cache, e);
+          image_hit_cnt++;
+          return image;
+        }
+    }
+  image_miss_cnt++;
+  return NULL;
+}
+
+/* Reads and checks the ELF header and program headers of FILE,
+   named FILE_NAME, and returns them as a new image, not yet in
+   the cache.  Returns a null pointer if FILE is not a valid
+   executable or if memory is exhausted.  The caller must hold
+   filesys_lock. */
+static struct image *image_read (struct file *file, const char *file_name)
+{
+  struct Elf32_Ehdr ehdr;
+  struct image *image;
+  size_t seg_cap = 0;
+  off_t file_ofs;
+  int i;
 
   /* Read and verify executable header. */
-  if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr ||
+  if (file_read_at (file, &ehdr, sizeof ehdr, 0) != sizeof ehdr ||
       memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7) || ehdr.e_type != 2 ||
       ehdr.e_machine != 3 || ehdr.e_version != 1 ||
       ehdr.e_phentsize != sizeof (struct Elf32_Phdr) || ehdr.e_phnum > 1024)
     {
       printf ("load: %s: error loading executable\n", file_name);
-      goto done;
+      return NULL;
     }
 
+  image = malloc (sizeof *image);
+  if (image == NULL)
+    return NULL;
+  image->file = NULL;
+  image->entry = ehdr.e_entry;
+  image->segs = NULL;
+  image->seg_cnt = 0;
+
   /* Read program headers. */
   file_ofs = ehdr.e_phoff;
   for (i = 0; i < ehdr.e_phnum; i++)
@@ -237,11 +811,9 @@ bool load (const char *file_name, void (**eip) (void), void **esp)
       struct Elf32_Phdr phdr;
 
       if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
-      file_seek (file, file_ofs);
-
-      if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
+        goto fail;
+      if (file_read_at (file, &phdr, sizeof phdr, file_ofs) != sizeof phdr)
+        goto fail;
       file_ofs += sizeof phdr;
       switch (phdr.p_type)
         {
@@ -255,59 +827,104 @@ bool load (const char *file_name, void (**eip) (void), void **esp)
           case PT_DYNAMIC:
           case PT_INTERP:
           case PT_SHLIB:
-            goto done;
+            goto fail;
           case PT_LOAD:
-            if (validate_segment (&phdr, file))
-              {
-                bool writable = (phdr.p_flags & PF_W) != 0;
-                uint32_t file_page = phdr.p_offset & ~PGMASK;
-                uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
-                uint32_t page_offset = phdr.p_vaddr & PGMASK;
-                uint32_t read_bytes, zero_bytes;
-                if (phdr.p_filesz > 0)
-                  {
-                    /* Normal segment.
-                       Read initial part from disk and zero the rest. */
-                    read_bytes = page_offset + phdr.p_filesz;
-                    zero_bytes =
-                        (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE) -
-                         read_bytes);
-                  }
-                else
-                  {
-                    /* Entirely zero.
-                       Don't read anything from disk. */
-                    read_bytes = 0;
-                    zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
-                  }
-                if (!load_segment (file, file_page, (void *) mem_page,
-                                   read_bytes, zero_bytes, writable))
-                  goto done;
-              }
-            else
-              goto done;
+            if (!validate_segment (&phdr, file) ||
+                !add_segment (image, &seg_cap, &phdr))
+              goto fail;
             break;
         }
     }
+  return image;
 
-  /* Set up stack. */
-  if (!setup_stack (esp))
-    goto done;
+fail:
+  image_free (image);
+  return NULL;
+}
 
-  /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
+/* Appends the loadable segment that PHDR describes to IMAGE,
+   whose segment array has room for *SEG_CAP segments, growing
+   the array if it is full.  Returns true if successful, false if
+   memory is exhausted. */
+static bool add_segment (struct image *image, size_t *seg_cap,
+                         const struct Elf32_Phdr *phdr)
+{
+  uint32_t page_offset = phdr->p_vaddr & PGMASK;
+  struct segment *seg;
 
-  success = true;
+  if (image->seg_cnt == *seg_cap)
+    {
+      size_t cap = *seg_cap > 0 ? *seg_cap * 2 : 4;
+      struct segment *segs = realloc (image->segs, cap * sizeof *segs);
 
-done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
-  return success;
+      if (segs == NULL)
+        return false;
+      image->segs = segs;
+      *seg_cap = cap;
+    }
+
+  seg = &image->segs[image->seg_cnt++];
+  seg->ofs = phdr->p_offset & ~PGMASK;
+  seg->upage = (uint8_t *) (phdr->p_vaddr & ~PGMASK);
+  seg->writable = (phdr->p_flags & PF_W) != 0;
+  if (phdr->p_filesz > 0)
+    {
+      /* Normal segment.
+         Read initial part from disk and zero the rest. */
+      seg->read_bytes = page_offset + phdr->p_filesz;
+      seg->zero_bytes =
+          ROUND_UP (page_offset + phdr->p_memsz, PGSIZE) - seg->read_bytes;
+    }
+  else
+    {
+      /* Entirely zero.
+         Don't read anything from disk. */
+      seg->read_bytes = 0;
+      seg->zero_bytes = ROUND_UP (page_offset + phdr->p_memsz, PGSIZE);
+    }
+  return true;
 }
 
-/* load() helpers. */
+/* Adds IMAGE, read from FILE, to the image cache, evicting the
+   least recently used image if the cache is full.  Returns true
+   if successful, false if FILE can't be held open, in which case
+   IMAGE is not cached.  The caller must hold filesys_lock. */
+static bool image_insert (struct image *image, struct file *file)
+{
+  image->file = file_reopen (file);
+  if (image->file == NULL)
+    return false;
+  image->version = inode_get_version (file_get_inode (file));
+
+  if (image_cache_cnt >= IMAGE_CACHE_SIZE)
+    image_evict (list_entry (list_back (&image_cache), struct image, elem));
+  list_push_front (&image_cache, &image->elem);
+  image_cache_cnt++;
+  return true;
+}
+
+/* Removes IMAGE from the image cache and frees it.  The caller
+   must hold filesys_lock. */
+static void image_evict (struct image *image)
+{
+  list_remove (&image->elem);
+  image_cache_cnt--;
+  image_free (image);
+}
+
+/* Frees IMAGE, which must not be in the image cache, closing its
+   file if it has one; the caller must then hold filesys_lock. */
+static void image_free (struct image *image)
+{
+  if (image->file != NULL)
+    file_close (image->file);
+  free (image->segs);
+  free (image);
+}
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -365,6 +982,10 @@ static bool validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   With virtual memory, the pages are only recorded in the
+   supplemental page table here, and each is read in by the page
+   fault handler when it is first accessed.
+
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
@@ -384,6 +1005,13 @@ static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+#ifdef VM
+      /* Record where the page's contents come from. */
+      if (!page_add_file (upage, file, ofs, page_read_bytes, page_zero_bytes,
+                          writable))
+        return false;
+      ofs += page_read_bytes;
+#else
       /* Get a page of memory. */
       uint8_t *kpage = palloc_get_page (PAL_USER);
       if (kpage == NULL)
@@ -403,6 +1031,7 @@ static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
           palloc_free_page (kpage);
           return false;
         }
+#endif
 
       /* Advance. */
       read_bytes -= page_read_bytes;
@@ -413,24 +1042,86 @@ static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
-static bool setup_stack (void **esp)
+   user virtual memory, then push the program's arguments onto it
+   as main() expects them.  CMD_LINE holds the arguments,
+   separated by spaces, and is only read.  It may be at most
+   EXEC_CMD_MAX bytes long, counting the null terminator, so that
+   every way of starting a process has the same limit; the
+   arguments then always fit in the one page.
+
+   CMD_LINE is split into words just once, as each word is copied
+   straight into the stack page.  Room for the words is reserved
+   below PHYS_BASE first; it is as long as CMD_LINE, which is at
+   least as long as the words packed together. */
+static bool setup_stack (void **esp, const char *cmd_line)
 {
-  uint8_t *kpage;
-  bool success = false;
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+  size_t cmd_len = strlen (cmd_line) + 1;
+  char *strings, *dst, **argv;
+  const char *src;
+  uint8_t *sp;
+  int argc, i;
+
+  if (cmd_len > EXEC_CMD_MAX)
+    return false;
 
-  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
-  if (kpage != NULL)
+#ifdef VM
+  if (!page_add_zero (upage, true) || !page_load (upage, true))
+    return false;
+#else
+  uint8_t *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+  if (kpage == NULL)
+    return false;
+  if (!install_page (upage, kpage, true))
     {
-      success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
-      if (success)
-        *esp = PHYS_BASE;
-      else
-        palloc_free_page (kpage);
+      palloc_free_page (kpage);
+      return false;
     }
-  return success;
+#endif
+
+  /* The page is mapped in the active page directory, so build
+     the frame through its user address.  First copy in the
+     words, each followed by a null terminator. */
+  strings = dst = (char *) PHYS_BASE - cmd_len;
+  argc = 0;
+  for (src = cmd_line + strspn (cmd_line, " "); *src != '\0';
+       src += strspn (src, " "))
+    {
+      size_t len = strcspn (src, " ");
+
+      memcpy (dst, src, len);
+      dst[len] = '\0';
+      dst += len + 1;
+      src += len;
+      argc++;
+    }
+
+  /* Then argv[] with its null sentinel, word-aligned below the
+     words, followed by argv, argc, and a fake return address. */
+  argv = (char **) ((uintptr_t) strings & ~(sizeof (char *) - 1)) -
+         (argc + 1);
+  sp = (uint8_t *) argv - sizeof (char **) - sizeof (int) - sizeof (void *);
+  if (sp < upage)
+    return false;
+  for (i = 0; i < argc; i++)
+    {
+      argv[i] = strings;
+      strings += strlen (strings) + 1;
+    }
+  argv[argc] = NULL;
+
+  sp = (uint8_t *) argv;
+  sp -= sizeof (char **);
+  *(char ***) sp = argv;
+  sp -= sizeof (int);
+  *(int *) sp = argc;
+  sp -= sizeof (void *);
+  *(void **) sp = NULL;
+  *esp = sp;
+  return true;
 }
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -449,3 +1140,4 @@ static bool install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL &&
           pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
@@ -3,9 +3,22 @@
 
 #include "threads/thread.h"
 
+struct intr_frame;
+
+/* Longest command line that a process can be started with, in
+   bytes, counting the null terminator.  exec() copies the line
+   onto the kernel stack, which has little room to spare.  User
+   programs see the same limit in lib/user/syscall.h. */
+#define EXEC_CMD_MAX 256
+
 tid_t process_execute (const char *file_name);
+#ifdef VM
+tid_t process_fork (const struct intr_frame *);
+#endif
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+void process_print_stats (void);
+void process_drop_stale_images (void);
 
 #endif /* userprog/process.h */
@@ -1,19 +1,1186 @@
 #include "userprog/syscall.h"
+#include <bitmap.h>
+#include <limits.h>
+#include <round.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include <uio.h>
 #include "devices/block.h"
+#include "devices/input.h"
+#include "devices/shutdown.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/pipe.h"
+#include "userprog/process.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
+
+/* Most bytes of a user buffer that read and write pin at once. */
+#define PIN_BATCH (16 * PGSIZE)
+
+/* Initial number of slots in a process's file descriptor
+   table.  The table doubles in size whenever it fills up. */
+#define FD_TABLE_INIT 16
+
+/* An open file descriptor, which refers either to a file or to
+   one end of a pipe. */
+struct fd
+{
+  struct file *file; /* Open file, or null for a pipe. */
+  struct pipe *pipe; /* Pipe, or null for a file. */
+  bool writer;       /* For a pipe, whether this is the write end. */
+};
+
+#ifdef VM
+/* A memory-mapped file. */
+struct mapping
+{
+  int mapid;             /* Mapping identifier. */
+  struct file *file;     /* File, reopened for the mapping. */
+  uint8_t *base;         /* First mapped page. */
+  size_t page_cnt;       /* Number of mapped pages. */
+  struct list_elem elem; /* Element in thread's `mappings' list. */
+};
+#endif
+
+struct lock filesys_lock;
 
 static void syscall_handler (struct intr_frame *);
 
+/* A system call handler.  The 80x86 calling convention passes
+   arguments as 32-bit words, so every handler can be called as
+   if it took four words, whatever it actually takes, and the
+   extra ones are ignored.  Likewise, the return value of a
+   handler that returns nothing is ignored by the caller. */
+typedef uint32_t syscall_func (uint32_t, uint32_t, uint32_t, uint32_t);
+
+/* Most arguments that any system call takes. */
+#define SYSCALL_MAX_ARGS 4
+
+/* A system call. */
+struct syscall
+{
+  size_t arg_cnt;     /* Number of arguments. */
+  syscall_func *func; /* Handler, or null if not implemented. */
+};
+
+static void sys_halt (void) NO_RETURN;
+static void sys_exit (int status) NO_RETURN;
+static int sys_exec (const char *cmd_line);
+static int sys_wait (int pid);
+static bool sys_create (const char *file, unsigned initial_size);
+static bool sys_remove (const char *file);
+static int sys_open (const char *file);
+static int sys_filesize (int fd);
+static int sys_read (int fd, void *buffer, unsigned size);
+static int sys_write (int fd, const void *buffer, unsigned size);
+static void sys_seek (int fd, unsigned position);
+static unsigned sys_tell (int fd);
+static void sys_close (int fd);
+static int sys_symlink (const char *target, const char *linkpath);
+static int sys_readv (int fd, const struct iovec *iov, int iovcnt);
+static int sys_writev (int fd, const struct iovec *iov, int iovcnt);
+static int sys_pread (int fd, void *buffer, unsigned size, unsigned offset);
+static int sys_pwrite (int fd, const void *buffer, unsigned size,
+                       unsigned offset);
+static int sys_pipe (int *fds);
+#ifdef VM
+static int sys_mmap (int fd, void *addr);
+static void sys_munmap (int mapid);
+static tid_t sys_fork (void);
+static void unmap (struct mapping *);
+#endif
+
+/* Casts handler FUNC to syscall_func.  Casting through the
+   generic function type tells the compiler that the mismatch is
+   deliberate. */
+#define SYSCALL(FUNC, ARG_CNT)                                     \
+  {                                                                \
+    ARG_CNT, (syscall_func *) (void (*) (void)) FUNC               \
+  }
+
+/* System calls, indexed by number (see lib/syscall-nr.h). */
+static const struct syscall syscall_table[] = {
+    [SYS_HALT] = SYSCALL (sys_halt, 0),
+    [SYS_EXIT] = SYSCALL (sys_exit, 1),
+    [SYS_EXEC] = SYSCALL (sys_exec, 1),
+    [SYS_WAIT] = SYSCALL (sys_wait, 1),
+    [SYS_CREATE] = SYSCALL (sys_create, 2),
+    [SYS_REMOVE] = SYSCALL (sys_remove, 1),
+    [SYS_OPEN] = SYSCALL (sys_open, 1),
+    [SYS_FILESIZE] = SYSCALL (sys_filesize, 1),
+    [SYS_READ] = SYSCALL (sys_read, 3),
+    [SYS_WRITE] = SYSCALL (sys_write, 3),
+    [SYS_SEEK] = SYSCALL (sys_seek, 2),
+    [SYS_TELL] = SYSCALL (sys_tell, 1),
+    [SYS_CLOSE] = SYSCALL (sys_close, 1),
+    [SYS_SYMLINK] = SYSCALL (sys_symlink, 2),
+    [SYS_READV] = SYSCALL (sys_readv, 3),
+    [SYS_WRITEV] = SYSCALL (sys_writev, 3),
+    [SYS_PREAD] = SYSCALL (sys_pread, 4),
+    [SYS_PWRITE] = SYSCALL (sys_pwrite, 4),
+    [SYS_PIPE] = SYSCALL (sys_pipe, 1),
+#ifdef VM
+    [SYS_MMAP] = SYSCALL (sys_mmap, 2),
+    [SYS_MUNMAP] = SYSCALL (sys_munmap, 1),
+    [SYS_FORK] = SYSCALL (sys_fork, 0),
+#endif
+};
+
+static int alloc_fd (struct file *, struct pipe *, bool writer);
+static struct fd *lookup_fd (int fd);
+static struct file *lookup_file (int fd);
+static void free_fd (int fd);
+static bool grow_fd_table (size_t fd_cnt);
+static bool inherit_fds (struct thread *parent, bool pipes_only);
+static inline bool get_user (uint8_t *dst, const uint8_t *usrc);
+static bool user_ok (const void *uaddr, size_t size, bool write);
+static void check_user (const void *uaddr, size_t size, bool write);
+static void copy_in (void *dst, const void *usrc, size_t size);
+static char *copy_in_string (const char *us);
+static bool copy_in_string_buf (char *dst, const char *us, size_t size);
+static size_t pin_batch_size (const void *uaddr, size_t size);
+static bool pin_user (const void *uaddr, size_t size, bool write);
+static void unpin_user (const void *uaddr, size_t size);
+static int read_user (struct fd *, uint8_t *ubuffer, size_t size,
+                      off_t *ofs);
+static int write_user (struct fd *, const uint8_t *ubuffer, size_t size,
+                       off_t *ofs);
+static struct iovec *copy_in_iov (const struct iovec *uiov, int iovcnt,
+                                  bool write);
+
 void syscall_init (void)
 {
+  lock_init (&filesys_lock);
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 
-static void syscall_handler (struct intr_frame *f UNUSED)
+/* Releases the open files and memory mappings of the running
+   process.  Called by process_exit(). */
+void syscall_process_exit (void)
 {
-  printf ("system call!\n");
+  struct thread *t = thread_current ();
+
+#ifdef VM
+  while (!list_empty (&t->mappings))
+    unmap (list_entry (list_front (&t->mappings), struct mapping, elem));
+#endif
+  if (t->fd_map != NULL)
+    {
+      size_t fd;
+
+      for (fd = 2; fd < t->fd_cnt; fd++)
+        if (bitmap_test (t->fd_map, fd))
+          sys_close (fd);
+      bitmap_destroy (t->fd_map);
+      free (t->fds);
+      t->fd_map = NULL;
+      t->fds = NULL;
+      t->fd_cnt = 0;
+    }
+}
+
+/* Gives the running process, a child that PARENT is starting
+   with exec(), the ends of pipes that PARENT has open, with the
+   same numbers, so that the two can talk through them.  Other
+   open files are not inherited.  Returns true if successful,
+   false on failure. */
+bool syscall_exec (struct thread *parent)
+{
+  return inherit_fds (parent, true);
+}
+
+#ifdef VM
+/* Gives the running process, a child that PARENT is forking,
+   copies of PARENT's open files and pipe ends, with the same
+   numbers and file positions.  Returns true if successful, false
+   on failure. */
+bool syscall_fork (struct thread *parent)
+{
+  return inherit_fds (parent, false);
+}
+#endif
+
+/* Dispatches the system call whose number and arguments are on
+   the user stack at F->esp, storing any return value in
+   F->eax. */
+static void syscall_handler (struct intr_frame *f)
+{
+  const struct syscall *sc;
+  uint32_t args[SYSCALL_MAX_ARGS];
+  uint32_t nr;
+
+#ifdef VM
+  /* Save the user context for fork() and the page fault
+     handler, for the duration of the call. */
+  thread_current ()->syscall_frame = f;
+#endif
+
+  copy_in (&nr, f->esp, sizeof nr);
+  if (nr >= sizeof syscall_table / sizeof *syscall_table)
+    sys_exit (-1);
+  sc = &syscall_table[nr];
+  if (sc->func == NULL)
+    sys_exit (-1);
+
+  memset (args, 0, sizeof args);
+  copy_in (args, (uint32_t *) f->esp + 1, sc->arg_cnt * sizeof *args);
+  f->eax = sc->func (args[0], args[1], args[2], args[3]);
+#ifdef VM
+  thread_current ()->syscall_frame = NULL;
+#endif
+}
+
+/* Halt system call. */
+static void sys_halt (void) { shutdown_power_off (); }
+
+/* Exit system call. */
+static void sys_exit (int status)
+{
+  thread_current ()->exit_status = status;
   thread_exit ();
-}
\ No newline at end of file
+}
+
+/* Exec system call.  The command line is copied into a buffer
+   on the stack, rather than a page of its own, and the child
+   builds its arguments straight from that copy. */
+static int sys_exec (const char *ucmd_line)
+{
+  char cmd_line[EXEC_CMD_MAX];
+
+  if (!copy_in_string_buf (cmd_line, ucmd_line, sizeof cmd_line))
+    return TID_ERROR;
+  return process_execute (cmd_line);
+}
+
+/* Wait system call. */
+static int sys_wait (int pid) { return process_wait (pid); }
+
+/* Create system call. */
+static bool sys_create (const char *ufile, unsigned initial_size)
+{
+  char *file = copy_in_string (ufile);
+  bool success;
+
+  lock_acquire (&filesys_lock);
+  success = filesys_create (file, initial_size);
+  lock_release (&filesys_lock);
+
+  palloc_free_page (file);
+  return success;
+}
+
+/* Remove system call. */
+static bool sys_remove (const char *ufile)
+{
+  char *file = copy_in_string (ufile);
+  bool success;
+
+  lock_acquire (&filesys_lock);
+  success = filesys_remove (file);
+  if (success)
+    process_drop_stale_images ();
+  lock_release (&filesys_lock);
+
+  palloc_free_page (file);
+  return success;
+}
+
+/* Open system call. */
+static int sys_open (const char *ufile)
+{
+  char *name = copy_in_string (ufile);
+  struct file *file;
+  int handle = -1;
+
+  lock_acquire (&filesys_lock);
+  file = filesys_open (name);
+  lock_release (&filesys_lock);
+
+  if (file != NULL)
+    {
+      handle = alloc_fd (file, NULL, false);
+      if (handle == -1)
+        {
+          lock_acquire (&filesys_lock);
+          file_close (file);
+          lock_release (&filesys_lock);
+        }
+    }
+
+  palloc_free_page (name);
+  return handle;
+}
+
+/* Filesize system call. */
+static int sys_filesize (int handle)
+{
+  struct file *file = lookup_file (handle);
+  int size;
+
+  if (file == NULL)
+    return -1;
+  lock_acquire (&filesys_lock);
+  size = file_length (file);
+  lock_release (&filesys_lock);
+
+  return size;
+}
+
+/* Read system call. */
+static int sys_read (int handle, void *ubuffer, unsigned size)
+{
+  struct fd *fd = NULL;
+  int bytes_read;
+
+  check_user (ubuffer, size, true);
+  if (handle != STDIN_FILENO)
+    {
+      fd = lookup_fd (handle);
+      if (fd->pipe != NULL && fd->writer)
+        return -1;
+    }
+
+  bytes_read = read_user (fd, ubuffer, size, NULL);
+  if (bytes_read < 0)
+    sys_exit (-1);
+  return bytes_read;
+}
+
+/* Write system call. */
+static int sys_write (int handle, const void *ubuffer, unsigned size)
+{
+  struct fd *fd = NULL;
+  int bytes_written;
+
+  check_user (ubuffer, size, false);
+  if (handle != STDOUT_FILENO)
+    {
+      fd = lookup_fd (handle);
+      if (fd->pipe != NULL && !fd->writer)
+        return -1;
+    }
+
+  bytes_written = write_user (fd, ubuffer, size, NULL);
+  if (bytes_written < 0)
+    sys_exit (-1);
+  return bytes_written;
+}
+
+/* Seek system call. */
+static void sys_seek (int handle, unsigned position)
+{
+  struct file *file = lookup_file (handle);
+
+  if (file == NULL)
+    return;
+  lock_acquire (&filesys_lock);
+  if ((off_t) position >= 0)
+    file_seek (file, position);
+  lock_release (&filesys_lock);
+}
+
+/* Tell system call. */
+static unsigned sys_tell (int handle)
+{
+  struct file *file = lookup_file (handle);
+  unsigned position;
+
+  if (file == NULL)
+    return -1;
+  lock_acquire (&filesys_lock);
+  position = file_tell (file);
+  lock_release (&filesys_lock);
+
+  return position;
+}
+
+/* Close system call. */
+static void sys_close (int handle)
+{
+  struct fd *fd = lookup_fd (handle);
+
+  if (fd->pipe != NULL)
+    pipe_close (fd->pipe, fd->writer);
+  else
+    {
+      lock_acquire (&filesys_lock);
+      file_close (fd->file);
+      lock_release (&filesys_lock);
+    }
+
+  free_fd (handle);
+}
+
+/* Symlink system call. */
+static int sys_symlink (const char *utarget, const char *ulinkpath)
+{
+  char *target = copy_in_string (utarget);
+  char *linkpath = copy_in_string (ulinkpath);
+  bool success;
+
+  lock_acquire (&filesys_lock);
+  success = filesys_symlink (target, linkpath);
+  lock_release (&filesys_lock);
+
+  palloc_free_page (target);
+  palloc_free_page (linkpath);
+  return success ? 0 : -1;
+}
+
+/* Readv system call.  The whole vector is copied in and checked
+   before any data moves, then each buffer is filled in turn as
+   by read(), stopping early at end of file. */
+static int sys_readv (int handle, const struct iovec *uiov, int iovcnt)
+{
+  struct fd *fd = NULL;
+  struct iovec *iov;
+  int bytes_read = 0;
+  int i;
+
+  if (handle != STDIN_FILENO)
+    {
+      fd = lookup_fd (handle);
+      if (fd->pipe != NULL && fd->writer)
+        return -1;
+    }
+  iov = copy_in_iov (uiov, iovcnt, true);
+  if (iov == NULL)
+    return -1;
+
+  for (i = 0; i < iovcnt; i++)
+    {
+      int retval = read_user (fd, iov[i].iov_base, iov[i].iov_len, NULL);
+      if (retval < 0)
+        {
+          free (iov);
+          sys_exit (-1);
+        }
+      bytes_read += retval;
+      if ((size_t) retval != iov[i].iov_len)
+        break;
+    }
+
+  free (iov);
+  return bytes_read;
+}
+
+/* Writev system call.  Works like sys_readv(), so that a process
+   that emits many small records pays for one system call instead
+   of one per record. */
+static int sys_writev (int handle, const struct iovec *uiov, int iovcnt)
+{
+  struct fd *fd = NULL;
+  struct iovec *iov;
+  int bytes_written = 0;
+  int i;
+
+  if (handle != STDOUT_FILENO)
+    {
+      fd = lookup_fd (handle);
+      if (fd->pipe != NULL && !fd->writer)
+        return -1;
+    }
+  iov = copy_in_iov (uiov, iovcnt, false);
+  if (iov == NULL)
+    return -1;
+
+  for (i = 0; i < iovcnt; i++)
+    {
+      int retval =
+          write_user (fd, iov[i].iov_base, iov[i].iov_len, NULL);
+      if (retval < 0)
+        {
+          free (iov);
+          sys_exit (-1);
+        }
+      bytes_written += retval;
+      if ((size_t) retval != iov[i].iov_len)
+        break;
+    }
+
+  free (iov);
+  return bytes_written;
+}
+
+/* Pread system call.  Like read(), but reads starting at OFFSET
+   instead of at the file position, which is left unchanged, so
+   that several readers of one file need not agree on where to
+   seek.  The console and pipes have no position, so they can't
+   be read this way. */
+static int sys_pread (int handle, void *ubuffer, unsigned size,
+                      unsigned offset)
+{
+  off_t ofs = offset;
+  struct fd *fd;
+  int bytes_read;
+
+  if (handle == STDIN_FILENO || handle == STDOUT_FILENO || ofs < 0)
+    return -1;
+  fd = lookup_fd (handle);
+  if (fd->file == NULL)
+    return -1;
+  check_user (ubuffer, size, true);
+
+  bytes_read = read_user (fd, ubuffer, size, &ofs);
+  if (bytes_read < 0)
+    sys_exit (-1);
+  return bytes_read;
+}
+
+/* Pwrite system call.  Like write(), but at OFFSET, as for
+   sys_pread(). */
+static int sys_pwrite (int handle, const void *ubuffer, unsigned size,
+                       unsigned offset)
+{
+  off_t ofs = offset;
+  struct fd *fd;
+  int bytes_written;
+
+  if (handle == STDIN_FILENO || handle == STDOUT_FILENO || ofs < 0)
+    return -1;
+  fd = lookup_fd (handle);
+  if (fd->file == NULL)
+    return -1;
+  check_user (ubuffer, size, false);
+
+  bytes_written = write_user (fd, ubuffer, size, &ofs);
+  if (bytes_written < 0)
+    sys_exit (-1);
+  return bytes_written;
+}
+
+/* Pipe system call.  Creates a pipe and stores descriptors for
+   its read end and its write end in UFDS[0] and UFDS[1],
+   respectively.  Returns 0 if successful, -1 on failure. */
+static int sys_pipe (int *ufds)
+{
+  struct pipe *p;
+  int fds[2];
+
+  check_user (ufds, sizeof fds, true);
+
+  p = pipe_create ();
+  if (p == NULL)
+    return -1;
+  fds[0] = alloc_fd (NULL, p, false);
+  if (fds[0] == -1)
+    {
+      pipe_close (p, false);
+      pipe_close (p, true);
+      return -1;
+    }
+  fds[1] = alloc_fd (NULL, p, true);
+  if (fds[1] == -1)
+    {
+      sys_close (fds[0]);
+      pipe_close (p, true);
+      return -1;
+    }
+
+  memcpy (ufds, fds, sizeof fds);
+  return 0;
+}
+
+#ifdef VM
+/* Mmap system call.
+
+   The file is reopened, so that the mapping stays valid after
+   the file descriptor is closed, and its pages are added to the
+   supplemental page table to be read in on demand. */
+static int sys_mmap (int handle, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct file *file;
+  struct mapping *m;
+  off_t length;
+  size_t i;
+
+  if (handle == STDIN_FILENO || handle == STDOUT_FILENO)
+    return -1;
+  file = lookup_file (handle);
+  if (file == NULL || addr == NULL || pg_ofs (addr) != 0)
+    return -1;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return -1;
+
+  lock_acquire (&filesys_lock);
+  m->file = file_reopen (file);
+  length = m->file != NULL ? file_length (m->file) : 0;
+  lock_release (&filesys_lock);
+  if (length == 0)
+    goto fail;
+
+  /* The mapping must fit in user space without overlapping any
+     other page. */
+  m->base = addr;
+  m->page_cnt = DIV_ROUND_UP (length, PGSIZE);
+  if (!is_user_vaddr (m->base + m->page_cnt * PGSIZE - 1))
+    goto fail;
+  for (i = 0; i < m->page_cnt; i++)
+    if (page_lookup (m->base + i * PGSIZE) != NULL)
+      goto fail;
+
+  for (i = 0; i < m->page_cnt; i++)
+    {
+      off_t ofs = i * PGSIZE;
+      off_t read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+
+      if (!page_add_mmap (m->base + ofs, m->file, ofs, read_bytes))
+        {
+          while (i-- > 0)
+            page_remove (m->base + i * PGSIZE);
+          goto fail;
+        }
+    }
+
+  m->mapid = t->next_mapid++;
+  list_push_back (&t->mappings, &m->elem);
+  return m->mapid;
+
+fail:
+  lock_acquire (&filesys_lock);
+  file_close (m->file);
+  lock_release (&filesys_lock);
+  free (m);
+  return -1;
+}
+
+/* Fork system call. */
+static tid_t sys_fork (void)
+{
+  return process_fork (thread_current ()->syscall_frame);
+}
+
+/* Munmap system call. */
+static void sys_munmap (int mapid)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->mappings); e != list_end (&t->mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->mapid == mapid)
+        {
+          unmap (m);
+          return;
+        }
+    }
+  sys_exit (-1);
+}
+
+/* Removes mapping M, writing modified pages back to the file,
+   and frees it. */
+static void unmap (struct mapping *m)
+{
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    page_remove (m->base + i * PGSIZE);
+
+  lock_acquire (&filesys_lock);
+  file_close (m->file);
+  lock_release (&filesys_lock);
+
+  list_remove (&m->elem);
+  free (m);
+}
+#endif
+
+/* Enters FILE, or else the write end of PIPE if WRITER is true
+   and its read end otherwise, into the running process's file
+   descriptor table under the lowest free descriptor number and
+   returns that number, or -1 if the table can't grow to make
+   room.
+
+   Descriptors 0 and 1, the console, are always marked in use
+   so that they are never handed out. */
+static int alloc_fd (struct file *file, struct pipe *pipe, bool writer)
+{
+  struct thread *t = thread_current ();
+  size_t fd = BITMAP_ERROR;
+
+  if (t->fd_map != NULL)
+    fd = bitmap_scan_and_flip (t->fd_map, 0, 1, false);
+  if (fd == BITMAP_ERROR)
+    {
+      size_t old_cnt = t->fd_cnt;
+
+      if (!grow_fd_table (old_cnt > 0 ? old_cnt * 2 : FD_TABLE_INIT))
+        return -1;
+      fd = bitmap_scan_and_flip (t->fd_map, old_cnt, 1, false);
+    }
+
+  t->fds[fd].file = file;
+  t->fds[fd].pipe = pipe;
+  t->fds[fd].writer = writer;
+  return fd;
+}
+
+/* Returns the running process's file descriptor numbered
+   HANDLE.  Terminates the process if there is no such file
+   descriptor. */
+static struct fd *lookup_fd (int handle)
+{
+  struct thread *t = thread_current ();
+
+  if (handle < 2 || (size_t) handle >= t->fd_cnt ||
+      !bitmap_test (t->fd_map, handle))
+    sys_exit (-1);
+  return &t->fds[handle];
+}
+
+/* Returns the open file that the running process's file
+   descriptor numbered HANDLE refers to, or a null pointer if it
+   refers to a pipe.  Terminates the process if there is no such
+   file descriptor. */
+static struct file *lookup_file (int handle)
+{
+  return lookup_fd (handle)->file;
+}
+
+/* Makes file descriptor HANDLE, which must be in use, free for
+   reuse. */
+static void free_fd (int handle)
+{
+  struct thread *t = thread_current ();
+
+  bitmap_reset (t->fd_map, handle);
+  t->fds[handle].file = NULL;
+  t->fds[handle].pipe = NULL;
+}
+
+/* Grows the running process's file descriptor table to FD_CNT
+   slots, creating it if it doesn't exist yet.  Returns true if
+   successful, false if memory is exhausted, in which case the
+   table is left as it was. */
+static bool grow_fd_table (size_t fd_cnt)
+{
+  struct thread *t = thread_current ();
+  struct fd *fds;
+  struct bitmap *fd_map;
+  size_t fd;
+
+  ASSERT (fd_cnt > t->fd_cnt || t->fd_map == NULL);
+
+  fd_map = bitmap_create (fd_cnt);
+  if (fd_map == NULL)
+    return false;
+  fds = realloc (t->fds, fd_cnt * sizeof *fds);
+  if (fds == NULL)
+    {
+      bitmap_destroy (fd_map);
+      return false;
+    }
+
+  if (t->fd_map != NULL)
+    {
+      for (fd = 0; fd < t->fd_cnt; fd++)
+        bitmap_set (fd_map, fd, bitmap_test (t->fd_map, fd));
+      bitmap_destroy (t->fd_map);
+    }
+  else
+    bitmap_set_multiple (fd_map, 0, 2, true);
+
+  t->fds = fds;
+  t->fd_map = fd_map;
+  t->fd_cnt = fd_cnt;
+  return true;
+}
+
+/* Gives the running process, a new child of PARENT, which is
+   blocked waiting for it, copies of PARENT's open pipe ends and,
+   unless PIPES_ONLY is true, of its open files, with the same
+   numbers and file positions.  Returns true if successful, false
+   on failure.  On failure, the descriptors copied so far are
+   left open, to be closed when the process exits. */
+static bool inherit_fds (struct thread *parent, bool pipes_only)
+{
+  struct thread *t = thread_current ();
+  bool success = true;
+  size_t fd;
+
+  if (parent->fd_map == NULL)
+    return true;
+  if (!grow_fd_table (parent->fd_cnt))
+    return false;
+
+  lock_acquire (&filesys_lock);
+  for (fd = 2; fd < parent->fd_cnt; fd++)
+    if (bitmap_test (parent->fd_map, fd))
+      {
+        struct fd *pfd = &parent->fds[fd];
+
+        if (pfd->pipe != NULL)
+          {
+            pipe_reopen (pfd->pipe, pfd->writer);
+            t->fds[fd].file = NULL;
+          }
+        else if (pipes_only)
+          continue;
+        else
+          {
+            struct file *file = file_reopen (pfd->file);
+
+            if (file == NULL)
+              {
+                success = false;
+                break;
+              }
+            file_seek (file, file_tell (pfd->file));
+            t->fds[fd].file = file;
+          }
+        t->fds[fd].pipe = pfd->pipe;
+        t->fds[fd].writer = pfd->writer;
+        bitmap_mark (t->fd_map, fd);
+      }
+  lock_release (&filesys_lock);
+  return success;
+}
+
+/* Copies a byte from user address USRC, which must be below
+   PHYS_BASE, to DST.  Returns true if successful, false if USRC
+   can't be read.
+
+   The access is made directly, with no check of the page tables.
+   The address of the accessing instruction, label "2", goes into
+   the .user_access section, which the linker gathers into a table
+   between _start_user_access and _end_user_access.  If the access
+   faults, syscall_fixup_fault() finds the faulting instruction in
+   the table, puts the address of the label "1" that we stashed in
+   EAX into EIP, and zeroes EAX, so that we resume as if the
+   access had been skipped. */
+static inline bool get_user (uint8_t *dst, const uint8_t *usrc)
+{
+  int eax;
+  asm("movl $1f, %%eax\n"
+      "2: movb %2, %%al\n"
+      ".pushsection .user_access, \"a\"\n"
+      ".long 2b\n"
+      ".popsection\n"
+      "movb %%al, %0\n"
+      "1:"
+      : "=m"(*dst), "=&a"(eax)
+      : "m"(*usrc));
+  return eax != 0;
+}
+
+/* Called by the page fault handler for a fault in the kernel on
+   a user address.  If the faulting instruction, at F->eip, is
+   the user memory access in get_user(), makes the access fail
+   as it expects and returns true.  Otherwise, the
+   fault is a kernel bug, and returns false.  Other code that
+   touches user memory, with memcpy() say, must have checked or
+   pinned it first, so that it can't fault for good. */
+bool syscall_fixup_fault (struct intr_frame *f)
+{
+  extern const uint32_t _start_user_access[], _end_user_access[];
+  const uint32_t *p;
+
+  for (p = _start_user_access; p < _end_user_access; p++)
+    if (*p == (uint32_t) f->eip)
+      {
+        f->eip = (void (*) (void)) f->eax;
+        f->eax = 0;
+        return true;
+      }
+  return false;
+}
+
+/* Returns true if all SIZE bytes starting at UADDR are user
+   memory that the running process may read, or also write if
+   WRITE is true.  Never writes to the memory, so that a probe
+   doesn't break copy-on-write sharing or dirty a page that the
+   system call then leaves alone.
+
+   With virtual memory, consults the supplemental page table
+   without bringing anything into memory, so that a large buffer
+   is faulted in only a batch at a time as pin_user() pins it;
+   pages just below the stack pointer are fine, since pinning
+   them grows the stack.  Otherwise, every user page is present,
+   so reading one byte of each page and checking its page table
+   entry suffices. */
+static bool user_ok (const void *uaddr_, size_t size, bool write)
+{
+  const uint8_t *uaddr = uaddr_;
+  const uint8_t *end = uaddr + size;
+  const uint8_t *p;
+
+  if (size == 0)
+    return true;
+  if (end < uaddr || !is_user_vaddr (end - 1))
+    return false;
+  for (p = uaddr; p < end; p = (const uint8_t *) pg_round_down (p) + PGSIZE)
+    {
+#ifdef VM
+      struct page *page = page_lookup (p);
+
+      if (page == NULL)
+        {
+          if (!page_is_stack (p, thread_current ()->syscall_frame->esp))
+            return false;
+        }
+      else if (write && !page->writable)
+        return false;
+#else
+      uint8_t byte;
+
+      if (!get_user (&byte, p) ||
+          (write && !pagedir_is_writable (thread_current ()->pagedir, p)))
+        return false;
+#endif
+    }
+  return true;
+}
+
+/* Terminates the process unless user_ok (UADDR, SIZE, WRITE). */
+static void check_user (const void *uaddr, size_t size, bool write)
+{
+  if (!user_ok (uaddr, size, write))
+    sys_exit (-1);
+}
+
+/* Copies SIZE bytes from user address USRC to DST.  Terminates
+   the process if USRC isn't valid. */
+static void copy_in (void *dst, const void *usrc, size_t size)
+{
+  check_user (usrc, size, false);
+  memcpy (dst, usrc, size);
+}
+
+/* Returns how many of the SIZE bytes at UADDR to pin in one
+   batch: no more than PIN_BATCH, and ending on a page boundary
+   unless that is the end of the buffer. */
+static size_t pin_batch_size (const void *uaddr, size_t size)
+{
+  size_t max = PIN_BATCH - pg_ofs (uaddr);
+  return size < max ? size : max;
+}
+
+/* Makes the SIZE bytes at UADDR, which check_user() has already
+   vetted, safe for the kernel to access while holding locks that
+   the page fault handler may need, for writing if WRITE is true.
+   With virtual memory, that means pinning them in memory.
+   Otherwise, user pages never leave memory anyway.  Returns true
+   if successful, false on failure. */
+static bool pin_user (const void *uaddr UNUSED, size_t size UNUSED,
+                      bool write UNUSED)
+{
+#ifdef VM
+  return page_pin (uaddr, size, write);
+#else
+  return true;
+#endif
+}
+
+/* Undoes pin_user (UADDR, SIZE, ...). */
+static void unpin_user (const void *uaddr UNUSED, size_t size UNUSED)
+{
+#ifdef VM
+  page_unpin (uaddr, size);
+#endif
+}
+
+/* Reads up to SIZE bytes into user buffer UBUFFER, which
+   check_user() has already vetted, from FD, or from the keyboard
+   if FD is null.  Reads a file from its position if OFS is null,
+   otherwise from *OFS, which is advanced past the bytes read.
+   File data is read straight into the user buffer, which is
+   pinned, a batch at a time, so that no page fault can happen
+   while the file system lock is held.  A pipe is read the same
+   way, but only as far as one pipe_read() goes, so that the
+   caller gets whatever data is ready without waiting for more.
+   Returns the number of bytes read, or -1 if the buffer could
+   not be pinned. */
+static int read_user (struct fd *fd, uint8_t *ubuffer, size_t size,
+                      off_t *ofs)
+{
+  size_t bytes_read = 0;
+
+  if (fd == NULL)
+    {
+      for (; bytes_read < size; bytes_read++)
+        ubuffer[bytes_read] = input_getc ();
+      return bytes_read;
+    }
+
+  while (bytes_read < size)
+    {
+      uint8_t *batch = ubuffer + bytes_read;
+      size_t batch_size = pin_batch_size (batch, size - bytes_read);
+      off_t retval;
+
+      if (!pin_user (batch, batch_size, true))
+        return -1;
+      if (fd->pipe != NULL)
+        retval = pipe_read (fd->pipe, batch, batch_size);
+      else
+        {
+          lock_acquire (&filesys_lock);
+          if (ofs == NULL)
+            retval = file_read (fd->file, batch, batch_size);
+          else
+            {
+              retval = file_read_at (fd->file, batch, batch_size, *ofs);
+              *ofs += retval;
+            }
+          lock_release (&filesys_lock);
+        }
+      unpin_user (batch, batch_size);
+
+      bytes_read += retval;
+      if (retval != (off_t) batch_size || fd->pipe != NULL)
+        break;
+    }
+  return bytes_read;
+}
+
+/* Writes up to SIZE bytes from user buffer UBUFFER, which
+   check_user() has already vetted, to FD, or to the console if
+   FD is null, at a file's position or at *OFS as in read_user().
+   The buffer is pinned a batch at a time, also as in
+   read_user().  Writing to a pipe blocks until all of the data
+   is in the pipe or every read end is closed.  Returns the
+   number of bytes written, or -1 if the buffer could not be
+   pinned. */
+static int write_user (struct fd *fd, const uint8_t *ubuffer,
+                       size_t size, off_t *ofs)
+{
+  size_t bytes_written = 0;
+
+  while (bytes_written < size)
+    {
+      const uint8_t *batch = ubuffer + bytes_written;
+      size_t batch_size = pin_batch_size (batch, size - bytes_written);
+      off_t retval;
+
+      if (!pin_user (batch, batch_size, false))
+        return -1;
+      if (fd == NULL)
+        {
+          putbuf ((const char *) batch, batch_size);
+          retval = batch_size;
+        }
+      else if (fd->pipe != NULL)
+        retval = pipe_write (fd->pipe, batch, batch_size);
+      else
+        {
+          lock_acquire (&filesys_lock);
+          if (ofs == NULL)
+            retval = file_write (fd->file, batch, batch_size);
+          else
+            {
+              retval = file_write_at (fd->file, batch, batch_size, *ofs);
+              *ofs += retval;
+            }
+          lock_release (&filesys_lock);
+        }
+      unpin_user (batch, batch_size);
+
+      bytes_written += retval;
+      if (retval != (off_t) batch_size)
+        break;
+    }
+  return bytes_written;
+}
+
+/* Copies the IOVCNT-element iovec array at user address UIOV
+   into a newly allocated kernel array, which the caller must
+   free, and checks that every buffer it describes is user memory
+   that the process may read, or also write if WRITE is true.
+
+   Returns a null pointer if IOVCNT is out of range, if the total
+   length of the buffers does not fit in an int (the return type
+   of readv() and writev()), or if memory is exhausted.
+   Terminates the process if any of the memory is invalid. */
+static struct iovec *copy_in_iov (const struct iovec *uiov, int iovcnt,
+                                  bool write)
+{
+  struct iovec *iov;
+  size_t sum = 0;
+  int i;
+
+  if (iovcnt <= 0 || iovcnt > IOV_MAX)
+    return NULL;
+  check_user (uiov, iovcnt * sizeof *uiov, false);
+  iov = malloc (iovcnt * sizeof *iov);
+  if (iov == NULL)
+    return NULL;
+  memcpy (iov, uiov, iovcnt * sizeof *iov);
+
+  for (i = 0; i < iovcnt; i++)
+    {
+      if (iov[i].iov_len > (size_t) INT_MAX - sum)
+        {
+          free (iov);
+          return NULL;
+        }
+      sum += iov[i].iov_len;
+      if (!user_ok (iov[i].iov_base, iov[i].iov_len, write))
+        {
+          free (iov);
+          sys_exit (-1);
+        }
+    }
+
+  return iov;
+}
+
+/* Copies the null-terminated string US from user memory into
+   the SIZE-byte kernel buffer DST.  Returns true if successful,
+   false if the string, with its null terminator, is longer than
+   SIZE bytes.  Terminates the process if US is invalid. */
+static bool copy_in_string_buf (char *dst, const char *us, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      if (!is_user_vaddr (us + i) ||
+          !get_user ((uint8_t *) dst + i, (const uint8_t *) us + i))
+        sys_exit (-1);
+      if (dst[i] == '\0')
+        return true;
+    }
+  return false;
+}
+
+/* Copies the null-terminated string US from user memory into a
+   newly allocated kernel page and returns it.  The caller must
+   free the page with palloc_free_page().  Terminates the process
+   if US is invalid or too long, or if memory is exhausted. */
+static char *copy_in_string (const char *us)
+{
+  char *ks = palloc_get_page (0);
+  size_t i;
+
+  if (ks == NULL)
+    sys_exit (-1);
+
+  for (i = 0; i < PGSIZE; i++)
+    {
+      if (!is_user_vaddr (us + i) ||
+          !get_user ((uint8_t *) ks + i, (const uint8_t *) us + i))
+        {
+          palloc_free_page (ks);
+          sys_exit (-1);
+        }
+      if (ks[i] == '\0')
+        return ks;
+    }
+
+  palloc_free_page (ks);
+  sys_exit (-1);
+}
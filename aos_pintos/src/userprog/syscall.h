@@ -2,7 +2,22 @@
 #define USERPROG_SYSCALL_H
 
 #include <stdbool.h>
+#include "threads/synch.h"
+
+/* Serializes access to the file system, which does no locking of
+   its own. */
+extern struct lock filesys_lock;
 
 void syscall_init (void);
+void syscall_process_exit (void);
+
+struct intr_frame;
+bool syscall_fixup_fault (struct intr_frame *);
+
+struct thread;
+bool syscall_exec (struct thread *parent);
+#ifdef VM
+bool syscall_fork (struct thread *parent);
+#endif
 
 #endif /* userprog/syscall.h */
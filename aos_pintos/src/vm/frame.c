@@ -0,0 +1,559 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include "devices/timer.h"
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+#include "vm/stats.h"
+#include "vm/swap.h"
+
+/* The frame table: every frame that holds a user page, in the
+   order that the clock hand sweeps them. */
+static struct list frames;
+
+/* Number of frames in FRAMES. */
+static size_t frame_cnt;
+
+/* Clock hand: the next frame to consider for eviction, or
+   list_end (&frames) to start over from the beginning. */
+static struct list_elem *hand;
+
+/* The working set sampler's position in the frame table, kept
+   valid like the clock hand. */
+static struct list_elem *ws_hand;
+
+/* Frames the working set sampler examines each time it acquires
+   the frame table lock. */
+#define WS_BATCH 32
+
+/* The sharing table: frames that hold read-only file pages,
+   keyed by file location, so that processes mapping the same
+   page can share one frame.  Frames that no page maps any longer
+   stay in the table, as a cache of clean file pages, until they
+   are evicted or the file is written. */
+static struct hash shared_frames;
+
+/* Protects the frame table and the sharing table, and also the
+   association between every page and its frame or swap slot, so
+   that a page can't be evicted while it is being loaded or
+   freed.  The lock is not held during disk I/O: the page is
+   marked in transit and its frame pinned instead (see
+   vm/page.h), so that faults that need no I/O, and I/O for other
+   pages, can proceed meanwhile. */
+static struct lock frame_lock;
+
+static struct frame *choose_victim (size_t *steps);
+static struct frame *evict_cluster (void);
+static bool is_swap_candidate (struct frame *);
+static bool evict (struct frame *);
+static bool test_and_clear_accessed (struct frame *);
+static void unshare (struct frame *);
+static void uncache (struct frame *);
+static thread_func ws_sampler;
+static void sample_working_sets (void);
+static thread_action_func finish_sample;
+static hash_hash_func share_hash;
+static hash_less_func share_less;
+
+/* Initializes the frame table.  With -vmstats, also starts the
+   working set sampler. */
+void frame_init (void)
+{
+  list_init (&frames);
+  frame_cnt = 0;
+  hand = ws_hand = list_end (&frames);
+  hash_init (&shared_frames, share_hash, share_less, NULL);
+  lock_init (&frame_lock);
+
+  if (vm_stats_enabled)
+    thread_create ("ws_sampler", PRI_DEFAULT, ws_sampler, NULL);
+}
+
+/* Acquires the frame table lock. */
+void frame_acquire (void) { lock_acquire (&frame_lock); }
+
+/* Releases the frame table lock. */
+void frame_release (void) { lock_release (&frame_lock); }
+
+/* Waits on COND, releasing the frame table lock while waiting.
+   The caller must hold the frame table lock. */
+void frame_wait (struct condition *cond) { cond_wait (cond, &frame_lock); }
+
+/* Wakes every thread waiting on COND.  The caller must hold the
+   frame table lock. */
+void frame_broadcast (struct condition *cond)
+{
+  cond_broadcast (cond, &frame_lock);
+}
+
+/* Obtains a frame to hold PAGE, alone, and returns it.  If the
+   user pool is exhausted, evicts other pages to make room.
+   Returns a null pointer if no frame can be obtained.  The caller
+   must hold the frame table lock. */
+struct frame *frame_alloc (struct page *page)
+{
+  struct frame *f;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  f = frame_try_alloc (page);
+  if (f == NULL)
+    {
+      f = evict_cluster ();
+      if (f == NULL)
+        return NULL;
+      list_init (&f->pages);
+      list_push_back (&f->pages, &page->frame_elem);
+      f->shared = false;
+      f->pin_cnt = 0;
+      f->swap_page = NULL;
+    }
+  return f;
+}
+
+/* Like frame_alloc(), but returns a null pointer instead of
+   evicting anything if the user pool is exhausted. */
+struct frame *frame_try_alloc (struct page *page)
+{
+  struct frame *f;
+  void *kpage;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  kpage = palloc_get_page (PAL_USER);
+  if (kpage == NULL)
+    return NULL;
+  f = malloc (sizeof *f);
+  if (f == NULL)
+    {
+      palloc_free_page (kpage);
+      return NULL;
+    }
+  f->kpage = kpage;
+  list_push_back (&frames, &f->elem);
+  frame_cnt++;
+
+  list_init (&f->pages);
+  list_push_back (&f->pages, &page->frame_elem);
+  f->shared = false;
+  f->pin_cnt = 0;
+  f->swap_page = NULL;
+  return f;
+}
+
+/* Removes frame F from the frame table and frees it.  The caller
+   must hold the frame table lock, and must already have unmapped
+   F's pages. */
+void frame_free (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  unshare (f);
+  uncache (f);
+  if (hand == &f->elem)
+    hand = list_next (hand);
+  if (ws_hand == &f->elem)
+    ws_hand = list_next (ws_hand);
+  list_remove (&f->elem);
+  frame_cnt--;
+  palloc_free_page (f->kpage);
+  free (f);
+}
+
+/* Returns the shared frame that holds the page of FILE made up
+   of READ_BYTES bytes starting at offset OFS, followed by zeros,
+   or a null pointer if there is none.  A frame read from an
+   earlier version of the file's inode is stale; it is dropped
+   from the table, and freed if no page maps it.  The caller must
+   hold the frame table lock. */
+struct frame *frame_lookup_shared (struct file *file, off_t ofs,
+                                   uint32_t read_bytes)
+{
+  struct inode *inode = file_get_inode (file);
+  struct frame key;
+  struct hash_elem *e;
+  struct frame *f;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  key.sector = inode_get_inumber (inode);
+  key.ofs = ofs;
+  key.read_bytes = read_bytes;
+  e = hash_find (&shared_frames, &key.share_elem);
+  if (e == NULL)
+    return NULL;
+
+  f = hash_entry (e, struct frame, share_elem);
+  if (f->version != inode_get_version (inode))
+    {
+      if (list_empty (&f->pages))
+        frame_free (f);
+      else
+        unshare (f);
+      return NULL;
+    }
+  return f;
+}
+
+/* Enters frame F, which holds the page of FILE described by OFS
+   and READ_BYTES as in frame_lookup_shared(), into the sharing
+   table.  The frame's contents must never change afterward.  The
+   caller must hold the frame table lock. */
+void frame_share (struct frame *f, struct file *file, off_t ofs,
+                  uint32_t read_bytes)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (!f->shared);
+
+  f->sector = inode_get_inumber (file_get_inode (file));
+  f->ofs = ofs;
+  f->read_bytes = read_bytes;
+  f->version = inode_get_version (file_get_inode (file));
+  if (hash_insert (&shared_frames, &f->share_elem) == NULL)
+    f->shared = true;
+}
+
+/* Pins frame F, so that it will not be evicted until a matching
+   call to frame_unpin().  The caller must hold the frame table
+   lock. */
+void frame_pin (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  f->pin_cnt++;
+}
+
+/* Undoes one call to frame_pin() on F.  The caller must hold the
+   frame table lock. */
+void frame_unpin (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (f->pin_cnt > 0);
+
+  f->pin_cnt--;
+}
+
+/* Adds PAGE to the pages that map frame F, which is either a
+   shared file frame or a copy-on-write frame.  The caller must
+   hold the frame table lock. */
+void frame_attach (struct frame *f, struct page *page)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  list_push_back (&f->pages, &page->frame_elem);
+}
+
+/* Removes PAGE, which must already be unmapped, from the pages
+   that map frame F.  If no page maps F any longer, frees it,
+   unless it is in the sharing table, where it stays to be found
+   again by frame_lookup_shared(), or pinned, in which case
+   whoever pinned it is still using it and the clock reclaims it
+   later.  The caller must hold the frame table lock. */
+void frame_detach (struct frame *f, struct page *page)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  list_remove (&page->frame_elem);
+  if (list_empty (&f->pages) && !f->shared && f->pin_cnt == 0)
+    frame_free (f);
+}
+
+/* Gives PAGE back frame F, which still holds PAGE's contents
+   although PAGE was swapped out of it.  The caller must hold the
+   frame table lock, and must then map PAGE and free its swap
+   slot. */
+void frame_reclaim (struct frame *f, struct page *page)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (f->swap_page == page && page->swap_cache == f);
+
+  f->swap_page = NULL;
+  page->swap_cache = NULL;
+  list_push_back (&f->pages, &page->frame_elem);
+}
+
+/* Chooses a frame to evict using the clock algorithm: sweeps the
+   hand around the frame table, clearing accessed bits as it
+   goes, and picks the first frame whose page has not been
+   accessed since the hand last passed it.  Stores the number of
+   frames examined in *STEPS.  Returns a null pointer if there is
+   no frame that can be evicted. */
+static struct frame *choose_victim (size_t *steps)
+{
+  size_t i;
+
+  if (frame_cnt == 0)
+    return NULL;
+
+  /* Two sweeps are normally enough, since the first clears every
+     accessed bit that the second might find set.  Other processes
+     keep running while we sweep, though, so if they keep touching
+     their pages we settle for the frame we end up on.  Pinned
+     frames are skipped, and if every frame is pinned, we give
+     up. */
+  for (i = 0; i < 3 * frame_cnt; i++)
+    {
+      struct frame *f;
+
+      if (hand == list_end (&frames))
+        hand = list_begin (&frames);
+      f = list_entry (hand, struct frame, elem);
+      hand = list_next (hand);
+
+      if (f->pin_cnt > 0)
+        continue;
+
+      /* A frame that no page maps is never accessed, so it goes
+         as soon as the hand reaches it. */
+      if (!test_and_clear_accessed (f) || i >= 2 * frame_cnt)
+        {
+          *steps = i + 1;
+          return f;
+        }
+    }
+  return NULL;
+}
+
+/* Chooses a frame with the clock and evicts it, returning the
+   frame, which then holds no page.  If the frame's page has to be
+   swapped out, up to SWAP_CLUSTER - 1 more frames in the same
+   situation are swapped out along with it, so that all of them
+   can be written to consecutive slots.  The extra frames keep
+   their contents, though, and stay in the frame table: their
+   pages can take them back on a fault without reading swap, and
+   the clock reclaims them without writing anything when it next
+   comes around.  Only the frame returned counts as an eviction.
+   Returns a null pointer if no frame can be evicted. */
+static struct frame *evict_cluster (void)
+{
+  struct vm_stats *s = &thread_current ()->vm_stats;
+  struct frame *victims[SWAP_CLUSTER];
+  struct page *pages[SWAP_CLUSTER];
+  size_t cnt, i, steps;
+
+  victims[0] = choose_victim (&steps);
+  if (victims[0] == NULL)
+    return NULL;
+  s->evictions++;
+  s->scan_steps += steps;
+  if (!is_swap_candidate (victims[0]))
+    return evict (victims[0]) ? victims[0] : NULL;
+
+  /* Gather more victims until the clock picks one that doesn't
+     need swapping, or comes around to one already picked. */
+  for (cnt = 1; cnt < SWAP_CLUSTER; cnt++)
+    {
+      struct frame *f = choose_victim (&steps);
+
+      if (f == NULL || !is_swap_candidate (f))
+        break;
+      for (i = 0; i < cnt; i++)
+        if (victims[i] == f)
+          break;
+      if (i < cnt)
+        break;
+      victims[cnt] = f;
+    }
+
+  for (i = 0; i < cnt; i++)
+    pages[i] = list_entry (list_front (&victims[i]->pages), struct page,
+                           frame_elem);
+  if (!page_out_cluster (pages, cnt))
+    return evict (victims[0]) ? victims[0] : NULL;
+
+  for (i = 1; i < cnt; i++)
+    {
+      list_remove (&pages[i]->frame_elem);
+      victims[i]->swap_page = pages[i];
+      pages[i]->swap_cache = victims[i];
+    }
+  return victims[0];
+}
+
+/* Returns true if frame F holds a single page that would have to
+   be swapped out to evict it. */
+static bool is_swap_candidate (struct frame *f)
+{
+  return (list_size (&f->pages) == 1 &&
+          page_needs_swap (list_entry (list_front (&f->pages), struct page,
+                                       frame_elem)));
+}
+
+/* Evicts every page that maps frame F, leaving F free for reuse.
+   Returns true if successful, false if a page can't be saved, in
+   which case F keeps the pages not yet evicted.  page_out()
+   releases the frame table lock while it writes a page, so pages
+   may come and go from F meanwhile. */
+static bool evict (struct frame *f)
+{
+  while (!list_empty (&f->pages))
+    {
+      struct page *p = list_entry (list_front (&f->pages), struct page,
+                                   frame_elem);
+
+      if (!page_out (p))
+        return false;
+      list_remove (&p->frame_elem);
+    }
+
+  unshare (f);
+  uncache (f);
+  return true;
+}
+
+/* Returns true if any page that maps frame F has been accessed
+   since the last call, clearing the accessed bits as it goes.
+   A page counts as accessed if either its hardware accessed bit
+   or the copy that the working set sampler saved is set. */
+static bool test_and_clear_accessed (struct frame *f)
+{
+  bool accessed = false;
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->thread->pagedir;
+
+      if (pagedir_is_accessed (pd, p->upage))
+        {
+          accessed = true;
+          pagedir_set_accessed (pd, p->upage, false);
+        }
+      if (p->accessed)
+        {
+          accessed = true;
+          p->accessed = false;
+        }
+    }
+  return accessed;
+}
+
+/* Thread function for the working set sampler, which samples
+   every process's working set each WS_SAMPLE_TICKS timer ticks,
+   whether or not the process is faulting. */
+static void ws_sampler (void *aux UNUSED)
+{
+  for (;;)
+    {
+      timer_sleep (WS_SAMPLE_TICKS);
+      sample_working_sets ();
+    }
+}
+
+/* Sweeps the frame table, crediting each page accessed since the
+   last sweep to the working set of the process that owns it.
+   Each hardware accessed bit that the sweep clears is saved in
+   the page, so that the clock hand still sees the access.
+
+   The frame table lock is held only for WS_BATCH frames at a
+   time, so that faulting processes wait for at most that many
+   frames, not for the whole sweep. */
+static void sample_working_sets (void)
+{
+  enum intr_level old_level;
+
+  lock_acquire (&frame_lock);
+  ws_hand = list_begin (&frames);
+  while (ws_hand != list_end (&frames))
+    {
+      size_t i;
+
+      for (i = 0; i < WS_BATCH && ws_hand != list_end (&frames); i++)
+        {
+          struct frame *f = list_entry (ws_hand, struct frame, elem);
+          struct list_elem *e;
+
+          ws_hand = list_next (ws_hand);
+          for (e = list_begin (&f->pages); e != list_end (&f->pages);
+               e = list_next (e))
+            {
+              struct page *p = list_entry (e, struct page, frame_elem);
+              uint32_t *pd = p->thread->pagedir;
+
+              if (pagedir_is_accessed (pd, p->upage))
+                {
+                  p->accessed = true;
+                  pagedir_set_accessed (pd, p->upage, false);
+                  p->thread->vm_stats.ws_current++;
+                }
+            }
+        }
+
+      /* Let a thread waiting for the lock have it before we take
+         it back. */
+      lock_release (&frame_lock);
+      thread_yield ();
+      lock_acquire (&frame_lock);
+    }
+  lock_release (&frame_lock);
+
+  old_level = intr_disable ();
+  thread_foreach (finish_sample, NULL);
+  intr_set_level (old_level);
+}
+
+/* Records the pages that the last sweep credited to process T as
+   one working set sample. */
+static void finish_sample (struct thread *t, void *aux UNUSED)
+{
+  struct vm_stats *s = &t->vm_stats;
+
+  if (t->pagedir == NULL)
+    return;
+
+  s->ws_samples++;
+  s->ws_total += s->ws_current;
+  if (s->ws_current > s->ws_peak)
+    s->ws_peak = s->ws_current;
+  s->ws_current = 0;
+}
+
+/* Removes frame F from the sharing table, if it is there. */
+static void unshare (struct frame *f)
+{
+  if (f->shared)
+    {
+      hash_delete (&shared_frames, &f->share_elem);
+      f->shared = false;
+    }
+}
+
+/* Forgets the swapped-out page whose contents frame F holds, if
+   any, so that the page will be read back from swap. */
+static void uncache (struct frame *f)
+{
+  if (f->swap_page != NULL)
+    {
+      f->swap_page->swap_cache = NULL;
+      f->swap_page = NULL;
+    }
+}
+
+/* Returns a hash value for the shared frame that E refers to. */
+static unsigned share_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (e, struct frame, share_elem);
+  return hash_int (f->sector) ^ hash_int (f->ofs) ^ f->read_bytes;
+}
+
+/* Returns true if shared frame A precedes shared frame B. */
+static bool share_less (const struct hash_elem *a_,
+                        const struct hash_elem *b_, void *aux UNUSED)
+{
+  const struct frame *a = hash_entry (a_, struct frame, share_elem);
+  const struct frame *b = hash_entry (b_, struct frame, share_elem);
+
+  if (a->sector != b->sector)
+    return a->sector < b->sector;
+  if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  return a->read_bytes < b->read_bytes;
+}
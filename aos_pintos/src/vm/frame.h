@@ -0,0 +1,71 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "devices/block.h"
+#include "filesys/off_t.h"
+
+struct condition;
+struct file;
+struct page;
+
+/* A frame of physical memory from the user pool, holding one
+   page of one or more user processes.
+
+   Usually a single page occupies a frame.  A read-only page of a
+   file, though, such as a page of program text, may be shared by
+   every process that maps the same part of the same file: the
+   frame is then entered in the sharing table under that file
+   location.  When the last page that maps it lets go, it stays
+   in the table, holding no page, so that the next process to run
+   the same program can map it without reading the file again;
+   the clock reclaims it like any other frame.  Likewise, after
+   fork(), parent and child share every frame read-only until one
+   of them writes to it.
+
+   A frame may also hold no page because its page was written to
+   swap along with a cluster of others before the clock came to
+   it.  SWAP_PAGE then names that page, whose contents the frame
+   still holds, so that a fault on the page can take the frame
+   back without reading swap, until the clock reclaims it. */
+struct frame
+{
+  void *kpage;           /* Kernel virtual address of the frame. */
+  struct list pages;     /* Pages that map the frame. */
+  struct list_elem elem; /* Element in the frame table. */
+  unsigned pin_cnt;      /* Not to be evicted while nonzero. */
+  struct page *swap_page; /* Swapped-out page still held, or null. */
+
+  /* Sharing table entry, if SHARED is true. */
+  bool shared;                 /* In the sharing table? */
+  block_sector_t sector;       /* File's inode sector. */
+  off_t ofs;                   /* Offset in file. */
+  uint32_t read_bytes;         /* Bytes read from file. */
+  unsigned version;            /* Inode version read from. */
+  struct hash_elem share_elem; /* Element in the sharing table. */
+};
+
+void frame_init (void);
+
+void frame_acquire (void);
+void frame_release (void);
+void frame_wait (struct condition *);
+void frame_broadcast (struct condition *);
+
+struct frame *frame_alloc (struct page *);
+struct frame *frame_try_alloc (struct page *);
+void frame_free (struct frame *);
+
+struct frame *frame_lookup_shared (struct file *, off_t, uint32_t read_bytes);
+void frame_share (struct frame *, struct file *, off_t,
+                  uint32_t read_bytes);
+void frame_pin (struct frame *);
+void frame_unpin (struct frame *);
+void frame_attach (struct frame *, struct page *);
+void frame_detach (struct frame *, struct page *);
+void frame_reclaim (struct frame *, struct page *);
+
+#endif /* vm/frame.h */
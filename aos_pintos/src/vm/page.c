@@ -0,0 +1,872 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/* Number of pages read into memory and written to swap. */
+static long long page_in_cnt, page_out_cnt;
+
+/* -sl: Maximum size of a process's stack, in pages. */
+size_t stack_max_pages = STACK_MAX_PAGES;
+
+/* The PUSHA instruction checks access permissions for all 32
+   bytes it pushes before it moves the stack pointer, so it may
+   fault this far below the stack pointer. */
+#define PUSHA_SLOP 32
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destructor;
+static struct page *page_add (void *upage, bool writable);
+static bool load_locked (struct page *, bool write);
+static bool page_in (struct page *, bool write);
+static bool map_zero_page (struct page *);
+static bool is_exclusive (const struct page *);
+static bool make_writable (struct page *);
+static bool is_shareable (const struct page *);
+static void swap_in_cluster (struct page *, struct frame *);
+static void write_back (struct page *);
+static void discard (struct page *);
+static void begin_transit (struct page *, struct frame *);
+static void end_transit (struct page *, struct frame *);
+static void wait_transit (struct page *);
+
+/* Initializes the running process's supplemental page table.
+   Returns true if successful, false on memory allocation
+   failure. */
+bool page_table_init (void)
+{
+  return hash_init (&thread_current ()->pages, page_hash, page_less, NULL);
+}
+
+/* Destroys the running process's supplemental page table,
+   freeing the frames and swap slots that its pages occupy. */
+void page_table_destroy (void)
+{
+  frame_acquire ();
+  hash_destroy (&thread_current ()->pages, page_destructor);
+  frame_release ();
+}
+
+/* Copies the supplemental page table of PARENT, which must be
+   blocked, into the running process's, for fork().  Pages in
+   frames are not copied but shared copy-on-write: both processes
+   map the frame read-only, and the first to write gets its own
+   copy (see make_writable()).  Pages in swap are first read
+   back in, so that they can be shared the same way.  Pages that
+   come from PARENT's file EXEC_FILE come from the running
+   process's EXEC_FILE instead.  Memory-mapped files are not
+   inherited.  Returns true if successful, false on failure. */
+bool page_table_clone (struct thread *parent, struct file *parent_exec,
+                       struct file *exec_file)
+{
+  struct hash_iterator i;
+  bool success = true;
+
+  frame_acquire ();
+  hash_first (&i, &parent->pages);
+  while (success && hash_next (&i))
+    {
+      struct page *pp = hash_entry (hash_cur (&i), struct page, hash_elem);
+      uint32_t *ppd = parent->pagedir;
+      struct page *c;
+
+      if (pp->mmap)
+        continue;
+      wait_transit (pp);
+      if (pp->swap_slot != SWAP_ERROR && !page_in (pp, false))
+        {
+          success = false;
+          break;
+        }
+
+      c = page_add (pp->upage, pp->writable);
+      if (c == NULL)
+        {
+          success = false;
+          break;
+        }
+      c->file = pp->file == parent_exec ? exec_file : pp->file;
+      c->ofs = pp->ofs;
+      c->read_bytes = pp->read_bytes;
+      c->zero_bytes = pp->zero_bytes;
+
+      if (pp->frame != NULL)
+        {
+          if (pp->writable)
+            {
+              /* If the parent modified the page, its contents no
+                 longer match the file, so neither copy may be
+                 reread from it.  Either way, the parent may no
+                 longer write to the shared frame. */
+              if (pagedir_is_dirty (ppd, pp->upage))
+                pp->file = c->file = NULL;
+              pagedir_clear_page (ppd, pp->upage);
+              success = pagedir_set_page (ppd, pp->upage, pp->frame->kpage,
+                                          false);
+            }
+          if (success)
+            success = pagedir_set_page (c->thread->pagedir, c->upage,
+                                        pp->frame->kpage, false);
+          if (success)
+            {
+              frame_attach (pp->frame, c);
+              c->frame = pp->frame;
+            }
+        }
+      else if (pp->zero_mapped)
+        success = map_zero_page (c);
+    }
+  frame_release ();
+  return success;
+}
+
+/* Returns the running process's page that contains ADDR, or a
+   null pointer if there is no such page. */
+struct page *page_lookup (const void *addr)
+{
+  struct page p;
+  struct hash_elem *e;
+
+  p.upage = pg_round_down (addr);
+  e = hash_find (&thread_current ()->pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Adds a page at UPAGE to the running process's supplemental
+   page table, whose contents are READ_BYTES bytes read from FILE
+   starting at offset OFS followed by ZERO_BYTES zeros.  The page
+   is read in when it is first accessed.  READ_BYTES + ZERO_BYTES
+   must equal PGSIZE.
+
+   Returns true if successful, false if UPAGE is already in the
+   table or on memory allocation failure. */
+bool page_add_file (void *upage, struct file *file, off_t ofs,
+                    uint32_t read_bytes, uint32_t zero_bytes, bool writable)
+{
+  struct page *p;
+
+  ASSERT (read_bytes + zero_bytes == PGSIZE);
+
+  p = page_add (upage, writable);
+  if (p == NULL)
+    return false;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  p->zero_bytes = zero_bytes;
+  return true;
+}
+
+/* Adds a page at UPAGE to the running process's supplemental
+   page table that initially contains all zeros.  Returns true if
+   successful, false if UPAGE is already in the table or on
+   memory allocation failure. */
+bool page_add_zero (void *upage, bool writable)
+{
+  return page_add (upage, writable) != NULL;
+}
+
+/* Adds a page at UPAGE to the running process's supplemental
+   page table that maps part of FILE: READ_BYTES bytes starting at
+   offset OFS, followed by zeros to the end of the page.  The page
+   is read in when it is first accessed, and written back to FILE
+   if it is modified.  Returns true if successful, false if UPAGE
+   is already in the table or on memory allocation failure. */
+bool page_add_mmap (void *upage, struct file *file, off_t ofs,
+                    uint32_t read_bytes)
+{
+  struct page *p;
+
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = page_add (upage, true);
+  if (p == NULL)
+    return false;
+  p->mmap = true;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  p->zero_bytes = PGSIZE - read_bytes;
+  return true;
+}
+
+/* Removes the page at UPAGE from the running process's
+   supplemental page table and frees the frame or swap slot that
+   holds it.  A memory-mapped file page that was modified is
+   first written back to its file. */
+void page_remove (void *upage)
+{
+  struct thread *t = thread_current ();
+  struct page *p = page_lookup (upage);
+
+  ASSERT (p != NULL);
+
+  frame_acquire ();
+  discard (p);
+  frame_release ();
+
+  hash_delete (&t->pages, &p->hash_elem);
+  free (p);
+}
+
+/* Brings the page containing ADDR into memory and maps it in the
+   running process's page directory, for writing if WRITE is
+   true.  Returns true if successful, false if ADDR isn't part of
+   a page in the supplemental page table, if WRITE is true but the
+   page is read-only, or if the page can't be loaded. */
+bool page_load (const void *addr, bool write)
+{
+  struct page *p;
+  bool success;
+
+  p = page_lookup (addr);
+  if (p == NULL)
+    return false;
+
+  frame_acquire ();
+  success = load_locked (p, write);
+  frame_release ();
+  return success;
+}
+
+/* Brings the SIZE bytes of user memory starting at UADDR into
+   memory, for writing if WRITE is true, and pins the frames that
+   hold them, so that the kernel can access them without faulting
+   until a matching call to page_unpin().  Pages just below the
+   user stack pointer saved on syscall entry grow the stack.
+   Returns true if successful, false if some page isn't valid or
+   can't be loaded, in which case nothing is left pinned.
+
+   All the pages are brought in under one acquisition of the
+   frame table lock, so callers should pin a large range at a
+   time, but not so large that pinning starves other processes
+   of frames. */
+bool page_pin (const void *uaddr, size_t size, bool write)
+{
+  struct thread *t = thread_current ();
+  const uint8_t *start = pg_round_down (uaddr);
+  const uint8_t *end = (const uint8_t *) uaddr + size;
+  const uint8_t *upage;
+
+  if (size == 0)
+    return true;
+
+  /* Stack growth adds pages, which must happen before we start
+     pinning. */
+  for (upage = start; upage < end; upage += PGSIZE)
+    if (page_lookup (upage) == NULL &&
+        (!page_is_stack (upage, t->syscall_frame->esp) ||
+         !page_grow_stack (upage)))
+      return false;
+
+  frame_acquire ();
+  for (upage = start; upage < end; upage += PGSIZE)
+    {
+      struct page *p = page_lookup (upage);
+
+      if (!load_locked (p, write))
+        {
+          frame_release ();
+          if (upage > start)
+            page_unpin (uaddr, upage - (const uint8_t *) uaddr);
+          return false;
+        }
+      if (p->frame != NULL)
+        frame_pin (p->frame);
+    }
+  frame_release ();
+  return true;
+}
+
+/* Unpins the frames pinned by page_pin (UADDR, SIZE, ...). */
+void page_unpin (const void *uaddr, size_t size)
+{
+  const uint8_t *end = (const uint8_t *) uaddr + size;
+  const uint8_t *upage;
+
+  if (size == 0)
+    return;
+
+  frame_acquire ();
+  for (upage = pg_round_down (uaddr); upage < end; upage += PGSIZE)
+    {
+      struct page *p = page_lookup (upage);
+
+      /* A page mapped to the zero page has no frame to unpin. */
+      if (p != NULL && p->frame != NULL)
+        frame_unpin (p->frame);
+    }
+  frame_release ();
+}
+
+/* Returns true if an access to ADDR, by a process whose stack
+   pointer is ESP, should be taken as an access to its stack, so
+   that the stack should grow to cover ADDR.  This is the case if
+   ADDR is at or just below ESP and within the stack size limit. */
+bool page_is_stack (const void *addr, const void *esp)
+{
+  const uint8_t *p = addr;
+  const uint8_t *stack_bottom =
+      (uint8_t *) PHYS_BASE - stack_max_pages * PGSIZE;
+
+  return (is_user_vaddr (p) && p >= stack_bottom &&
+          p + PUSHA_SLOP >= (const uint8_t *) esp);
+}
+
+/* Extends the running process's stack with a zeroed page that
+   covers ADDR and brings it into memory.  Returns true if
+   successful, false on memory allocation failure. */
+bool page_grow_stack (const void *addr)
+{
+  void *upage = pg_round_down (addr);
+
+  if (page_lookup (upage) == NULL && !page_add_zero (upage, true))
+    return false;
+  return page_load (upage, true);
+}
+
+/* Evicts page P from its frame, saving its contents unless they
+   can be recovered from P's file: a modified memory-mapped page
+   is written back to its file, any other page to swap.  Returns
+   true if successful, false if swap is full, in which case P
+   stays in its frame.  The caller must hold the frame table
+   lock, which is released while P is written. */
+bool page_out (struct page *p)
+{
+  uint32_t *pd = p->thread->pagedir;
+
+  ASSERT (p->frame != NULL);
+
+  /* Unmap the page before checking whether it is dirty, so that
+     the process can't modify it behind our back.  If the process
+     touches the page now, it will fault and wait until the page
+     is no longer in transit. */
+  pagedir_clear_page (pd, p->upage);
+
+  if (p->mmap)
+    {
+      if (pagedir_is_dirty (pd, p->upage))
+        {
+          write_back (p);
+          page_out_cnt++;
+        }
+    }
+  else if (p->file == NULL || pagedir_is_dirty (pd, p->upage))
+    {
+      begin_transit (p, p->frame);
+      frame_release ();
+      p->swap_slot = swap_out (p->frame->kpage);
+      frame_acquire ();
+      end_transit (p, p->frame);
+      if (p->swap_slot == SWAP_ERROR)
+        {
+          pagedir_set_page (pd, p->upage, p->frame->kpage,
+                            is_exclusive (p));
+          pagedir_set_dirty (pd, p->upage, true);
+          return false;
+        }
+
+      /* The page's contents now live in swap, not the file. */
+      swap_set_owner (p->swap_slot, p);
+      p->file = NULL;
+      p->thread->vm_stats.swap_outs++;
+      page_out_cnt++;
+    }
+
+  p->frame = NULL;
+  return true;
+}
+
+/* Returns true if page P, which must be in a frame, would have to
+   be written to swap if it were evicted now.  The caller must
+   hold the frame table lock. */
+bool page_needs_swap (struct page *p)
+{
+  ASSERT (p->frame != NULL);
+
+  return (!p->mmap && (p->file == NULL ||
+                       pagedir_is_dirty (p->thread->pagedir, p->upage)));
+}
+
+/* Evicts the CNT pages in PAGES[], each of which must be in a
+   frame of its own and need to be swapped out, writing them to
+   consecutive swap slots in a single transfer.  Returns true if
+   successful.  Returns false if swap has no run of CNT free slots,
+   in which case all the pages stay in their frames.  The caller
+   must hold the frame table lock, which is released while the
+   pages are written. */
+bool page_out_cluster (struct page *pages[], size_t cnt)
+{
+  void *kpages[SWAP_CLUSTER];
+  size_t slot, i;
+
+  ASSERT (cnt > 0 && cnt <= SWAP_CLUSTER);
+
+  /* Unmap the pages first, as in page_out().  Once unmapped,
+     they can no longer be modified, so they still need to be
+     swapped out. */
+  for (i = 0; i < cnt; i++)
+    {
+      ASSERT (page_needs_swap (pages[i]));
+      pagedir_clear_page (pages[i]->thread->pagedir, pages[i]->upage);
+      kpages[i] = pages[i]->frame->kpage;
+    }
+
+  slot = swap_alloc (cnt);
+  if (slot == SWAP_ERROR)
+    {
+      for (i = 0; i < cnt; i++)
+        {
+          struct page *p = pages[i];
+          uint32_t *pd = p->thread->pagedir;
+          bool dirty = pagedir_is_dirty (pd, p->upage);
+
+          pagedir_set_page (pd, p->upage, p->frame->kpage, p->writable);
+          pagedir_set_dirty (pd, p->upage, dirty);
+        }
+      return false;
+    }
+
+  for (i = 0; i < cnt; i++)
+    begin_transit (pages[i], pages[i]->frame);
+  frame_release ();
+  swap_write (slot, kpages, cnt);
+  frame_acquire ();
+  for (i = 0; i < cnt; i++)
+    {
+      struct page *p = pages[i];
+
+      end_transit (p, p->frame);
+      p->swap_slot = slot + i;
+      swap_set_owner (p->swap_slot, p);
+      p->file = NULL;
+      p->frame = NULL;
+      p->thread->vm_stats.swap_outs++;
+      page_out_cnt++;
+    }
+  return true;
+}
+
+/* Prints paging statistics. */
+void page_print_stats (void)
+{
+  printf ("Paging: %lld pages in, %lld pages out\n", page_in_cnt,
+          page_out_cnt);
+}
+
+/* Adds a page at UPAGE to the running process's supplemental
+   page table, with no contents yet.  Returns the new page, or a
+   null pointer if UPAGE is already in the table or on memory
+   allocation failure. */
+static struct page *page_add (void *upage, bool writable)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+
+  p->upage = upage;
+  p->thread = thread_current ();
+  p->writable = writable;
+  p->frame = NULL;
+  p->accessed = false;
+  p->swap_slot = SWAP_ERROR;
+  p->swap_cache = NULL;
+  p->in_transit = false;
+  cond_init (&p->transit_done);
+  p->zero_mapped = false;
+  p->mmap = false;
+  p->file = NULL;
+  p->ofs = 0;
+  p->read_bytes = 0;
+  p->zero_bytes = PGSIZE;
+  if (hash_insert (&p->thread->pages, &p->hash_elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Reads page P, which must not be in a frame, into a new frame
+   and maps it.  If P is a read-only file page that another
+   process already has in a frame, maps that frame instead, and
+   if P was swapped out of a frame that still holds its contents,
+   takes that frame back.  If P is still all zeros and WRITE is
+   false, maps the zero page instead; P is then brought into a
+   frame of its own only when it is first written.  Returns true
+   if successful, false otherwise.  The caller must hold the
+   frame table lock, which is released while P is read. */
+static bool page_in (struct page *p, bool write)
+{
+  struct frame *f;
+
+  if (!write && map_zero_page (p))
+    return true;
+  if (p->zero_mapped)
+    {
+      pagedir_clear_page (p->thread->pagedir, p->upage);
+      p->zero_mapped = false;
+    }
+
+  if (is_shareable (p))
+    {
+      f = frame_lookup_shared (p->file, p->ofs, p->read_bytes);
+      if (f != NULL)
+        {
+          if (!pagedir_set_page (p->thread->pagedir, p->upage, f->kpage,
+                                 false))
+            return false;
+          frame_attach (f, p);
+          p->frame = f;
+          p->thread->vm_stats.minor_faults++;
+          return true;
+        }
+    }
+
+  if (p->swap_cache != NULL)
+    {
+      f = p->swap_cache;
+      if (!pagedir_set_page (p->thread->pagedir, p->upage, f->kpage,
+                             p->writable))
+        return false;
+      frame_reclaim (f, p);
+      swap_free (p->swap_slot);
+      p->swap_slot = SWAP_ERROR;
+      p->frame = f;
+      p->thread->vm_stats.minor_faults++;
+      return true;
+    }
+
+  f = frame_alloc (p);
+  if (f == NULL)
+    return false;
+
+  if (p->swap_slot != SWAP_ERROR)
+    {
+      swap_in_cluster (p, f);
+      p->thread->vm_stats.major_faults++;
+    }
+  else
+    {
+      if (p->read_bytes > 0)
+        {
+          off_t bytes_read;
+
+          begin_transit (p, f);
+          frame_release ();
+          lock_acquire (&filesys_lock);
+          bytes_read = file_read_at (p->file, f->kpage, p->read_bytes, p->ofs);
+          lock_release (&filesys_lock);
+          frame_acquire ();
+          end_transit (p, f);
+          if (bytes_read != (off_t) p->read_bytes)
+            {
+              frame_free (f);
+              return false;
+            }
+          p->thread->vm_stats.major_faults++;
+        }
+      else
+        p->thread->vm_stats.minor_faults++;
+      memset ((uint8_t *) f->kpage + p->read_bytes, 0, p->zero_bytes);
+      if (is_shareable (p))
+        frame_share (f, p->file, p->ofs, p->read_bytes);
+    }
+
+  if (!pagedir_set_page (p->thread->pagedir, p->upage, f->kpage,
+                         p->writable))
+    {
+      frame_free (f);
+      return false;
+    }
+  p->frame = f;
+  page_in_cnt++;
+  return true;
+}
+
+/* Reads page P from swap into frame F.  Pages of the same process
+   that were swapped out to the slots just after P's, in the same
+   cluster, are likely to be needed soon too, so they are read in
+   along with it and mapped, as long as free frames are available
+   for them.  Pages of other processes are never read in this
+   way, since they would only take frames from this one.  A page
+   whose frame still holds its contents is read into that frame,
+   which costs no more than skipping it.  The caller must hold
+   the frame table lock, which is released during the read. */
+static void swap_in_cluster (struct page *p, struct frame *f)
+{
+  struct page *pages[SWAP_CLUSTER];
+  void *kpages[SWAP_CLUSTER];
+  size_t cnt, i;
+
+  pages[0] = p;
+  kpages[0] = f->kpage;
+  for (cnt = 1; cnt < SWAP_CLUSTER; cnt++)
+    {
+      struct page *q = swap_get_owner (p->swap_slot + cnt);
+      struct frame *g;
+
+      if (q == NULL || q->thread != p->thread)
+        break;
+      if (q->swap_cache != NULL)
+        {
+          g = q->swap_cache;
+          frame_reclaim (g, q);
+        }
+      else
+        {
+          g = frame_try_alloc (q);
+          if (g == NULL)
+            break;
+        }
+
+      /* Map the page before reading it.  It belongs to the
+         running process, which can't touch it until we return. */
+      if (!pagedir_set_page (q->thread->pagedir, q->upage, g->kpage,
+                             q->writable))
+        {
+          frame_free (g);
+          break;
+        }
+      q->frame = g;
+      pages[cnt] = q;
+      kpages[cnt] = g->kpage;
+    }
+
+  for (i = 0; i < cnt; i++)
+    begin_transit (pages[i], i == 0 ? f : pages[i]->frame);
+  frame_release ();
+  swap_read (p->swap_slot, kpages, cnt);
+  frame_acquire ();
+  for (i = 0; i < cnt; i++)
+    {
+      end_transit (pages[i], i == 0 ? f : pages[i]->frame);
+      pages[i]->swap_slot = SWAP_ERROR;
+      pages[i]->thread->vm_stats.swap_ins++;
+    }
+  page_in_cnt += cnt - 1;
+}
+
+/* Maps page P read-only to the zero page, a single frame of
+   zeros shared by every page that has never been written, if P
+   has all-zero contents.  Returns true if successful, false if
+   P's contents aren't all zeros or on failure.  The caller must
+   hold the frame table lock. */
+static bool map_zero_page (struct page *p)
+{
+  static void *zero_kpage;
+
+  if (p->mmap || p->read_bytes > 0 || p->swap_slot != SWAP_ERROR)
+    return false;
+
+  /* The zero page comes from the kernel pool, outside the frame
+     table, so it is never evicted. */
+  if (zero_kpage == NULL)
+    {
+      zero_kpage = palloc_get_page (PAL_ZERO);
+      if (zero_kpage == NULL)
+        return false;
+    }
+
+  if (!pagedir_set_page (p->thread->pagedir, p->upage, zero_kpage, false))
+    return false;
+  p->zero_mapped = true;
+  p->thread->vm_stats.minor_faults++;
+  return true;
+}
+
+/* Brings page P into memory and maps it, for writing if WRITE is
+   true, as described for page_load(), first waiting for any I/O
+   already under way on P.  The caller must hold the frame table
+   lock, which may be released meanwhile. */
+static bool load_locked (struct page *p, bool write)
+{
+  wait_transit (p);
+  if (write && !p->writable)
+    return false;
+  else if (p->frame != NULL)
+    return !write || make_writable (p);
+  else
+    return (p->zero_mapped && !write) || page_in (p, write);
+}
+
+/* Returns true if page P, which must be in a frame, may be
+   mapped writable: it is writable, and its frame is its own
+   rather than shared copy-on-write with another process. */
+static bool is_exclusive (const struct page *p)
+{
+  return p->writable && list_size (&p->frame->pages) == 1;
+}
+
+/* Handles a write to page P, which is in a frame but may be
+   mapped read-only because it shares the frame copy-on-write.
+   Gives P a copy of the frame if the frame is still shared, then
+   maps P writable.  Returns true if successful, false if no frame
+   is available.  The caller must hold the frame table lock. */
+static bool make_writable (struct page *p)
+{
+  uint32_t *pd = p->thread->pagedir;
+  struct frame *old = p->frame;
+  struct frame *f;
+
+  ASSERT (p->writable);
+
+  pagedir_clear_page (pd, p->upage);
+  if (list_size (&old->pages) == 1)
+    return pagedir_set_page (pd, p->upage, old->kpage, true);
+
+  /* Copy the shared frame, keeping it from being evicted while we
+     find a frame for the copy.  Finding one may release the frame
+     table lock, and the other pages that map OLD may let go of it
+     meanwhile, but being pinned, it is not freed. */
+  frame_pin (old);
+  frame_detach (old, p);
+  f = frame_alloc (p);
+  frame_unpin (old);
+  if (f == NULL)
+    {
+      frame_attach (old, p);
+      pagedir_set_page (pd, p->upage, old->kpage, false);
+      return false;
+    }
+  memcpy (f->kpage, old->kpage, PGSIZE);
+  p->frame = f;
+  if (!pagedir_set_page (pd, p->upage, f->kpage, true))
+    return false;
+
+  /* The copy exists only in memory now. */
+  p->file = NULL;
+  p->thread->vm_stats.minor_faults++;
+  return true;
+}
+
+/* Returns true if page P may share its frame with other
+   processes: it is a read-only page read from a file, so its
+   contents always match the file. */
+static bool is_shareable (const struct page *p)
+{
+  return !p->writable && !p->mmap && p->file != NULL;
+}
+
+/* Writes memory-mapped page P, which must be in a frame and
+   unmapped, back to its file.  The caller must hold the frame
+   table lock, which is released during the write. */
+static void write_back (struct page *p)
+{
+  ASSERT (p->mmap);
+  ASSERT (p->frame != NULL);
+
+  begin_transit (p, p->frame);
+  frame_release ();
+  lock_acquire (&filesys_lock);
+  file_write_at (p->file, p->frame->kpage, p->read_bytes, p->ofs);
+  lock_release (&filesys_lock);
+  frame_acquire ();
+  end_transit (p, p->frame);
+}
+
+/* Frees the frame or swap slot that holds page P, writing P back
+   to its file first if it is a modified memory-mapped page.  A
+   shared frame is only freed once no other page maps it.  The
+   caller must hold the frame table lock, which may be released
+   meanwhile. */
+static void discard (struct page *p)
+{
+  uint32_t *pd = p->thread->pagedir;
+
+  wait_transit (p);
+  if (p->frame != NULL)
+    {
+      pagedir_clear_page (pd, p->upage);
+      if (p->mmap && pagedir_is_dirty (pd, p->upage))
+        write_back (p);
+      frame_detach (p->frame, p);
+      p->frame = NULL;
+    }
+  else if (p->swap_slot != SWAP_ERROR)
+    {
+      if (p->swap_cache != NULL)
+        frame_free (p->swap_cache);
+      swap_free (p->swap_slot);
+      p->swap_slot = SWAP_ERROR;
+    }
+  else if (p->zero_mapped)
+    {
+      pagedir_clear_page (pd, p->upage);
+      p->zero_mapped = false;
+    }
+}
+
+/* Marks page P, whose contents are about to be read into or
+   written out of frame F, as in transit, and pins F, so that the
+   caller may release the frame table lock for the I/O.  The
+   caller must hold the frame table lock. */
+static void begin_transit (struct page *p, struct frame *f)
+{
+  ASSERT (!p->in_transit);
+
+  frame_pin (f);
+  p->in_transit = true;
+}
+
+/* Ends the transit of page P to or from frame F begun by
+   begin_transit(), waking anyone waiting for it.  The caller must
+   hold the frame table lock again. */
+static void end_transit (struct page *p, struct frame *f)
+{
+  ASSERT (p->in_transit);
+
+  p->in_transit = false;
+  frame_unpin (f);
+  frame_broadcast (&p->transit_done);
+}
+
+/* Waits until page P is not in transit.  The caller must hold
+   the frame table lock, which is released while waiting. */
+static void wait_transit (struct page *p)
+{
+  while (p->in_transit)
+    frame_wait (&p->transit_done);
+}
+
+/* Returns a hash value for the page that E refers to. */
+static unsigned page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if page A precedes page B. */
+static bool page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+                       void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+
+  return a->upage < b->upage;
+}
+
+/* Frees the page that E refers to, along with the frame or swap
+   slot that holds it. */
+static void page_destructor (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+
+  discard (p);
+  free (p);
+}
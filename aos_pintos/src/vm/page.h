@@ -0,0 +1,91 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+struct thread;
+
+/* A virtual page of a user process, as recorded in the process's
+   supplemental page table.
+
+   The supplemental page table says where each page's contents
+   come from, so that pages need not be brought into memory until
+   they are first accessed, and can be evicted again later.  The
+   hardware page table, managed by userprog/pagedir.c, maps only
+   the pages that are present.
+
+   FRAME, SWAP_SLOT, and SWAP_CACHE may change whenever the page
+   is evicted, so they may be examined or changed only with the
+   frame table lock held (see vm/frame.c).  So may ACCESSED, which
+   holds the hardware accessed bit of a page in a frame after the
+   working set sampler has cleared it, until the clock hand
+   consumes it.
+
+   While a page's contents are being read into or written out of
+   a frame, the frame is pinned and the page is IN_TRANSIT, and
+   the frame table lock is released for the I/O.  Anyone else
+   who needs the page meanwhile waits for TRANSIT_DONE. */
+struct page
+{
+  void *upage;                /* User virtual address. */
+  struct thread *thread;      /* Process that owns the page. */
+  struct hash_elem hash_elem; /* Element in thread's `pages' table. */
+  bool writable;              /* May the process write the page? */
+
+  struct frame *frame;        /* Frame holding the page, or null. */
+  struct list_elem frame_elem; /* Element in frame's `pages' list. */
+  bool accessed;               /* Accessed since the hand passed? */
+  bool zero_mapped;            /* Mapped read-only to the zero page? */
+  size_t swap_slot;    /* Swap slot holding the page, or SWAP_ERROR. */
+  struct frame *swap_cache; /* Frame still holding it, if in swap. */
+  bool in_transit;                /* Being read or written? */
+  struct condition transit_done;  /* Signaled when I/O is done. */
+
+  /* Initial contents: READ_BYTES bytes read from FILE starting
+     at offset OFS, followed by ZERO_BYTES zero bytes.  FILE is
+     null if the page's contents live only in memory or swap.
+
+     If MMAP is true, the page is part of a memory-mapped file:
+     it is written back to FILE, rather than to swap, when it is
+     evicted or unmapped after being modified. */
+  bool mmap;           /* Memory-mapped file page? */
+  struct file *file;   /* File to read from. */
+  off_t ofs;           /* Offset in FILE. */
+  uint32_t read_bytes; /* Bytes to read from FILE. */
+  uint32_t zero_bytes; /* Bytes to zero after those read. */
+};
+
+/* Default limit on the size of a process's stack, in pages. */
+#define STACK_MAX_PAGES 2048
+
+extern size_t stack_max_pages;
+
+bool page_table_init (void);
+void page_table_destroy (void);
+bool page_table_clone (struct thread *parent, struct file *parent_exec,
+                       struct file *exec_file);
+
+struct page *page_lookup (const void *);
+bool page_add_file (void *upage, struct file *, off_t,
+                    uint32_t read_bytes, uint32_t zero_bytes, bool writable);
+bool page_add_zero (void *upage, bool writable);
+bool page_add_mmap (void *upage, struct file *, off_t, uint32_t read_bytes);
+void page_remove (void *upage);
+bool page_load (const void *, bool write);
+bool page_is_stack (const void *addr, const void *esp);
+bool page_grow_stack (const void *addr);
+bool page_pin (const void *uaddr, size_t size, bool write);
+void page_unpin (const void *uaddr, size_t size);
+bool page_out (struct page *);
+bool page_needs_swap (struct page *);
+bool page_out_cluster (struct page *pages[], size_t cnt);
+
+void page_print_stats (void);
+
+#endif /* vm/page.h */
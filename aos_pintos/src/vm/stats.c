@@ -0,0 +1,75 @@
+#include "vm/stats.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* -vmstats: Print each process's VM statistics when it exits. */
+bool vm_stats_enabled;
+
+/* A page fault, as recorded in the fault trace. */
+struct fault_record
+{
+  const void *addr; /* Faulting address. */
+  const void *eip;  /* Faulting instruction. */
+  tid_t tid;        /* Thread that faulted. */
+  bool write;       /* Write access? */
+  bool user;        /* Fault in user mode? */
+};
+
+/* The fault trace: a ring of the most recent page faults, for
+   debugging.  A power of 2 in size. */
+#define TRACE_SIZE 64
+static struct fault_record trace[TRACE_SIZE];
+
+/* Number of faults ever recorded in the trace. */
+static unsigned trace_cnt;
+
+/* Prints the VM statistics S of the process called NAME. */
+void vm_stats_print (const char *name, const struct vm_stats *s)
+{
+  printf ("%s: vm: %lld minor and %lld major faults, "
+          "%lld swap ins, %lld swap outs\n",
+          name, s->minor_faults, s->major_faults, s->swap_ins,
+          s->swap_outs);
+  printf ("%s: vm: %lld evictions scanning %lld frames, "
+          "working set %lld pages average, %zu peak\n",
+          name, s->evictions, s->scan_steps,
+          s->ws_samples > 0 ? s->ws_total / s->ws_samples : 0, s->ws_peak);
+}
+
+/* Records a page fault at ADDR by the instruction at EIP in the
+   fault trace.  Must be called with interrupts off. */
+void vm_trace_fault (const void *addr, const void *eip, bool write, bool user)
+{
+  struct fault_record *r = &trace[trace_cnt++ % TRACE_SIZE];
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  r->addr = addr;
+  r->eip = eip;
+  r->tid = thread_current ()->tid;
+  r->write = write;
+  r->user = user;
+}
+
+/* Prints the fault trace, most recent fault first.  Safe to call
+   while panicking. */
+void vm_trace_dump (void)
+{
+  unsigned n = trace_cnt < TRACE_SIZE ? trace_cnt : TRACE_SIZE;
+  unsigned i;
+
+  if (n == 0)
+    return;
+
+  printf ("Recent page faults, most recent first:\n");
+  for (i = 1; i <= n; i++)
+    {
+      const struct fault_record *r = &trace[(trace_cnt - i) % TRACE_SIZE];
+
+      printf ("  tid %d: %s %s at %p, eip %p\n", r->tid,
+              r->user ? "user" : "kernel", r->write ? "write" : "read",
+              r->addr, r->eip);
+    }
+}
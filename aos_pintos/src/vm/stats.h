@@ -0,0 +1,37 @@
+#ifndef VM_STATS_H
+#define VM_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Virtual memory statistics for one process. */
+struct vm_stats
+{
+  long long minor_faults; /* Faults satisfied without I/O. */
+  long long major_faults; /* Faults that read from file or swap. */
+  long long swap_ins;     /* Pages read from swap. */
+  long long swap_outs;    /* Pages written to swap. */
+  long long evictions;    /* Frames evicted to satisfy our faults. */
+  long long scan_steps;   /* Frames the clock examined to do so. */
+
+  /* Working set estimate: the number of resident pages accessed
+     in each sampling interval. */
+  long long ws_samples;  /* Number of samples taken. */
+  long long ws_total;    /* Sum of all samples. */
+  size_t ws_peak;        /* Largest sample. */
+  size_t ws_current;     /* Pages counted so far this interval. */
+};
+
+/* Ticks between working set samples. */
+#define WS_SAMPLE_TICKS 10
+
+extern bool vm_stats_enabled;
+
+void vm_stats_print (const char *name, const struct vm_stats *);
+
+void vm_trace_fault (const void *addr, const void *eip, bool write,
+                     bool user);
+void vm_trace_dump (void);
+
+#endif /* vm/stats.h */
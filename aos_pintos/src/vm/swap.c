@@ -0,0 +1,151 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* The swap device is divided into page-sized "slots", each of
+   which can hold the contents of one page of virtual memory.
+
+   Pages are written out in clusters of up to SWAP_CLUSTER pages
+   to consecutive slots, and read back in clusters as well, so
+   that a cluster takes one run of the disk.  Frames aren't
+   contiguous in memory, so each page of a cluster is transferred
+   straight to or from its own frame, one multi-sector transfer
+   per page. */
+
+/* Number of sectors per swap slot. */
+#define SECTORS_PER_SLOT (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* The swap device, or a null pointer if there is none. */
+static struct block *swap_device;
+
+/* Slots in use, one bit per slot.  Null if there is no swap
+   device. */
+static struct bitmap *used_slots;
+
+/* The page whose contents each slot in use holds. */
+static struct page **owners;
+
+/* Protects USED_SLOTS and OWNERS. */
+static struct lock swap_lock;
+
+/* Sets up swapping on the BLOCK_SWAP device, if there is one. */
+void swap_init (void)
+{
+  size_t slot_cnt;
+
+  lock_init (&swap_lock);
+
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device == NULL)
+    {
+      printf ("swap: no swap device, swapping disabled\n");
+      return;
+    }
+
+  slot_cnt = block_size (swap_device) / SECTORS_PER_SLOT;
+  used_slots = bitmap_create (slot_cnt);
+  owners = calloc (slot_cnt, sizeof *owners);
+  if (used_slots == NULL || owners == NULL)
+    PANIC ("swap: allocation failed");
+}
+
+/* Allocates CNT consecutive free swap slots and returns the index
+   of the first, or SWAP_ERROR if there is no such run. */
+size_t swap_alloc (size_t cnt)
+{
+  size_t slot;
+
+  if (swap_device == NULL)
+    return SWAP_ERROR;
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip (used_slots, 0, cnt, false);
+  lock_release (&swap_lock);
+  return slot;
+}
+
+/* Writes the CNT pages at KPAGES[] to the CNT slots starting at
+   SLOT, which must have been obtained from swap_alloc(). */
+void swap_write (size_t slot, void *const kpages[], size_t cnt)
+{
+  size_t i;
+
+  ASSERT (cnt > 0 && cnt <= SWAP_CLUSTER);
+
+  for (i = 0; i < cnt; i++)
+    block_write_multiple (swap_device, (slot + i) * SECTORS_PER_SLOT,
+                          SECTORS_PER_SLOT, kpages[i]);
+}
+
+/* Reads the CNT slots starting at SLOT into the pages at
+   KPAGES[] and frees the slots. */
+void swap_read (size_t slot, void *const kpages[], size_t cnt)
+{
+  size_t i;
+
+  ASSERT (cnt > 0 && cnt <= SWAP_CLUSTER);
+
+  for (i = 0; i < cnt; i++)
+    {
+      block_read_multiple (swap_device, (slot + i) * SECTORS_PER_SLOT,
+                           SECTORS_PER_SLOT, kpages[i]);
+      swap_free (slot + i);
+    }
+}
+
+/* Writes the page at KPAGE to a free swap slot and returns the
+   slot's index, or SWAP_ERROR if no slot is free. */
+size_t swap_out (const void *kpage)
+{
+  size_t slot = swap_alloc (1);
+
+  if (slot != SWAP_ERROR)
+    swap_write (slot, (void *const *) &kpage, 1);
+  return slot;
+}
+
+/* Reads the contents of swap slot SLOT into KPAGE and frees the
+   slot. */
+void swap_in (size_t slot, void *kpage) { swap_read (slot, &kpage, 1); }
+
+/* Marks swap slot SLOT free without reading it. */
+void swap_free (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  bitmap_reset (used_slots, slot);
+  owners[slot] = NULL;
+  lock_release (&swap_lock);
+}
+
+/* Records that swap slot SLOT, which must be in use, holds the
+   contents of PAGE. */
+void swap_set_owner (size_t slot, struct page *page)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  owners[slot] = page;
+  lock_release (&swap_lock);
+}
+
+/* Returns the page whose contents swap slot SLOT holds, or a null
+   pointer if SLOT is free, out of range, or has no owner
+   recorded. */
+struct page *swap_get_owner (size_t slot)
+{
+  struct page *page = NULL;
+
+  if (swap_device == NULL)
+    return NULL;
+
+  lock_acquire (&swap_lock);
+  if (slot < bitmap_size (used_slots) && bitmap_test (used_slots, slot))
+    page = owners[slot];
+  lock_release (&swap_lock);
+  return page;
+}
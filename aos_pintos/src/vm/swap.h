@@ -0,0 +1,26 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stddef.h>
+#include <bitmap.h>
+
+struct page;
+
+/* Returned by swap_out() if there is no free swap slot. */
+#define SWAP_ERROR BITMAP_ERROR
+
+/* Maximum number of pages written or read in one transfer. */
+#define SWAP_CLUSTER 8
+
+void swap_init (void);
+size_t swap_alloc (size_t cnt);
+void swap_write (size_t slot, void *const kpages[], size_t cnt);
+void swap_read (size_t slot, void *const kpages[], size_t cnt);
+size_t swap_out (const void *kpage);
+void swap_in (size_t slot, void *kpage);
+void swap_free (size_t slot);
+
+void swap_set_owner (size_t slot, struct page *);
+struct page *swap_get_owner (size_t slot);
+
+#endif /* vm/swap.h */